@@ -13,6 +13,10 @@
  *                         the macros will have a prefix (everything before x) and a suffix (x):
  * - MTL_ARCHITECTURE_x     -- defines one macro prefixed by MTL_ARCHITECTURE_ where x is X86_64, ARM_32 or ARM_64
  * - MTL_CPU_INSTR_x        -- x is X86_64 (for intel 64 bits), ARMv6 (for rPi1), ARMv7 (for rPi2) or ARMv8 (for rPi3)
+ * - MTL_CPU_INSTR_RTM      -- the target may have Intel's Restricted Transactional Memory (TSX) instructions and we know how
+ *                             to emit them -- availability must still be checked at runtime (see 'thread/rtm.h')
+ * - MTL_CPU_INSTR_WAITPKG  -- the target may have Intel's UMONITOR/UMWAIT/TPAUSE instructions and we know how to emit them
+ *                             -- availability must still be checked at runtime (see 'thread/cpu_relax.h')
  * - MTL_CACHE_LINE_x       -- x is 64 (bytes, for intel & ARMv8) or 32 (bytes, for ARMv6 & ARMv7)
  * - MTL_OS_x               -- x is Linux, FreeBSD, Unix or Windows
  * - MTL_COMPILER_x         -- x is GCC, Clang or MSVC
@@ -38,6 +42,14 @@
     #define MTL_CACHE_LINE_32       1
     #define MTL_CACHE_LINE_SIZE     32
     #define MTL_CACHE_LINE          "32"
+#elif __aarch64__
+    #define MTL_ARCHITECTURE_ARM_64 1
+    #define MTL_ARCHITECTURE        "ARM_64"
+    #define MTL_CPU_INSTR_ARMv8     1
+    #define MTL_CPU_INSTR           "ARMv8"
+    #define MTL_CACHE_LINE_64       1
+    #define MTL_CACHE_LINE_SIZE     64
+    #define MTL_CACHE_LINE          "64"
 #elif __x86_64
     #define MTL_ARCHITECTURE_X86_64 1
     #define MTL_ARCHITECTURE        "X86_64"
@@ -81,6 +93,16 @@
     #define MTL_COMPILER       "GCC"
 #endif
 
+// MTL_CPU_INSTR_RTM
+#if MTL_CPU_INSTR_X86_64 && (MTL_COMPILER_GCC || MTL_COMPILER_Clang)
+    #define MTL_CPU_INSTR_RTM 1
+#endif
+
+// MTL_CPU_INSTR_WAITPKG
+#if MTL_CPU_INSTR_X86_64 && (MTL_COMPILER_GCC || MTL_COMPILER_Clang)
+    #define MTL_CPU_INSTR_WAITPKG 1
+#endif
+
 // MTL_COMPILER_VERSION
 #define MTL_COMPILER_VERSION __VERSION__
 
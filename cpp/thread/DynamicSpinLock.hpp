@@ -0,0 +1,292 @@
+/*! \file DynamicSpinLock.hpp
+    \brief `SpinLock`'s strategies, spin methods & hard lock fallback thresholds, chosen at runtime.
+
+    Allows A/B testing lock strategies on live hosts, without rebuilding -- at the cost of an indirect call per operation.
+*/
+
+#ifndef MTL_THREAD_DynamicSpinLock_hpp_
+#define MTL_THREAD_DynamicSpinLock_hpp_
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <iterator>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+
+#include "SpinLock.hpp"
+#include "../BetterExceptions.h"
+
+
+namespace MTL::thread {
+
+    /** the jump table through which a `DynamicSpinLock` dispatches its operations to the chosen lock specialization */
+    struct DynamicSpinLockOperations {
+        void (*construct)(void* specialization);
+        void (*destruct) (void* specialization);
+        void (*lock)     (void* specialization, uint64_t hardLockFallbackAfterCycles);
+        bool (*try_lock) (void* specialization);
+        void (*unlock)   (void* specialization);
+    };
+
+    /** the lock strategies a `DynamicSpinLock` may choose from, along with the storage needed for any of them */
+    template <ELockSpecializations... _lockStrategies>
+    struct DynamicSpinLockStrategies {
+        static constexpr ELockSpecializations values[] = {_lockStrategies...};
+        // the spin method doesn't change the specializations' layout
+        static constexpr size_t size      = std::max({sizeof (typename TLockSpecialization<ESpinMethod::CPURelax, _lockStrategies>::type)...});
+        static constexpr size_t alignment = std::max({alignof(typename TLockSpecialization<ESpinMethod::CPURelax, _lockStrategies>::type)...});
+    };
+
+    /**
+     * DynamicSpinLock.hpp
+     * ===================
+     *
+     * A `SpinLock` whose lock strategy, spin method and hard lock fallback threshold are given at construction time --
+     * either directly or through a configuration string like "RMWLight:CPURelax:100000" (which may come from an
+     * environment variable, see @ref fromEnvironment()). The chosen `XXXXLockSpecialization` lives inside this object and
+     * 'lock()', 'try_lock()' & 'unlock()' are dispatched through a `DynamicSpinLockOperations` jump table.
+     *
+     * The fully static `SpinLock` template remains the zero-overhead option: use this one to find out, on the real
+     * hardware & workload, which options to bake into it.
+     *
+    */
+    class DynamicSpinLock {
+
+    public:
+
+        /** value for 'hardLockFallbackAfterCycles' denoting no controlled spin -- like `SpinLock`'s default, 'lock()'
+          * goes straight to the specialization's 'hard_lock' */
+        static constexpr uint64_t NoHardLockFallback = !(uint64_t)0;
+
+    private:
+
+        typedef DynamicSpinLockStrategies<ELockSpecializations::Mutex,    ELockSpecializations::Futex,     ELockSpecializations::AtomicFlag,
+                                          ELockSpecializations::RMWLight, ELockSpecializations::Ouroboros, ELockSpecializations::Ticket,
+                                          ELockSpecializations::MCS,      ELockSpecializations::CLH,       ELockSpecializations::Elided,
+                                          ELockSpecializations::ElidedFutex, ELockSpecializations::Cohort, ELockSpecializations::CohortOuroboros,
+                                          ELockSpecializations::PIFutex>
+                Strategies;
+        static constexpr auto& lockStrategies = Strategies::values;
+        static constexpr const char* lockStrategyNames[] = {
+            "Mutex",    "Futex",     "AtomicFlag",
+            "RMWLight", "Ouroboros", "Ticket",
+            "MCS",      "CLH",       "Elided",
+            "ElidedFutex", "Cohort", "CohortOuroboros",
+            "PIFutex",
+        };
+        static constexpr ESpinMethod spinMethods[] = {
+            ESpinMethod::NoOp, ESpinMethod::CPURelax, ESpinMethod::CPURelax10, ESpinMethod::Yield, ESpinMethod::ExponentialBackoff,
+            ESpinMethod::WaitOnAddress,
+        };
+        static constexpr const char* spinMethodNames[] = {
+            "NoOp",            "CPURelax",            "CPURelax10",            "Yield",            "ExponentialBackoff",
+            "WaitOnAddress",
+        };
+        static_assert(std::size(lockStrategies) == std::size(lockStrategyNames), "'lockStrategies' and 'lockStrategyNames' must be of the same length");
+        static_assert(std::size(spinMethods)    == std::size(spinMethodNames),   "'spinMethods' and 'spinMethodNames' must be of the same length");
+
+        /** the 'DynamicSpinLockOperations' implementation for each spin method & lock strategy combination */
+        template <ESpinMethod _spinMethod, ELockSpecializations _lockStrategy>
+        struct Operations {
+            typedef typename TLockSpecialization<_spinMethod, _lockStrategy>::type LockSpecialization;
+
+            static void construct(void* specialization) {
+                new (specialization) LockSpecialization();
+            }
+            static void destruct(void* specialization) {
+                static_cast<LockSpecialization*>(specialization)->~LockSpecialization();
+            }
+            /** mirrors the controlled spin of `SpinLock::lock()`, with the threshold known only at runtime */
+            static void lock(void* specialization, uint64_t hardLockFallbackAfterCycles) {
+                LockSpecialization& lockSpecialization = *static_cast<LockSpecialization*>(specialization);
+                // cohort locks hand over only to the waiters '_hard_lock()' registers, so they can't do the controlled spin
+                if ( (hardLockFallbackAfterCycles == NoHardLockFallback) || isCohortLockStrategy<_lockStrategy>() ) {
+                    lockSpecialization._hard_lock();
+                    helperESpinMethodWaitEnded<_spinMethod>();
+                    return;
+                }
+                uint64_t waitingToLockStart = getProcessorCycleCount();
+                while (!lockSpecialization._try_lock()) {
+                    helperESpinMethodOn<_spinMethod>(lockSpecialization);
+                    if ((getProcessorCycleCount()-waitingToLockStart) > hardLockFallbackAfterCycles) {
+                        lockSpecialization._hard_lock();
+                        break;
+                    }
+                }
+                helperESpinMethodWaitEnded<_spinMethod>();
+            }
+            static bool try_lock(void* specialization) {
+                return static_cast<LockSpecialization*>(specialization)->_try_lock();
+            }
+            static void unlock(void* specialization) {
+                static_cast<LockSpecialization*>(specialization)->_unlock();
+            }
+
+            static constexpr DynamicSpinLockOperations table = {construct, destruct, lock, try_lock, unlock};
+        };
+
+        template <ESpinMethod _spinMethod, size_t... _i>
+        static const DynamicSpinLockOperations& operationsFor(ELockSpecializations lockStrategy, std::index_sequence<_i...>) {
+            static constexpr const DynamicSpinLockOperations* tables[] = {&Operations<_spinMethod, lockStrategies[_i]>::table...};
+            for (size_t i=0; i<std::size(lockStrategies); i++) {
+                if (lockStrategies[i] == lockStrategy) {
+                    return *tables[i];
+                }
+            }
+            THROW_EXCEPTION(std::invalid_argument, "Unsupported lock strategy '"s + std::to_string((int)lockStrategy));
+        }
+
+        static const DynamicSpinLockOperations& operationsFor(ELockSpecializations lockStrategy, ESpinMethod spinMethod) {
+            auto strategies = std::make_index_sequence<std::size(lockStrategies)>();
+            switch (spinMethod) {
+                case ESpinMethod::NoOp:               return operationsFor<ESpinMethod::NoOp>              (lockStrategy, strategies);
+                case ESpinMethod::CPURelax:           return operationsFor<ESpinMethod::CPURelax>          (lockStrategy, strategies);
+                case ESpinMethod::CPURelax10:         return operationsFor<ESpinMethod::CPURelax10>        (lockStrategy, strategies);
+                case ESpinMethod::Yield:              return operationsFor<ESpinMethod::Yield>             (lockStrategy, strategies);
+                case ESpinMethod::ExponentialBackoff: return operationsFor<ESpinMethod::ExponentialBackoff>(lockStrategy, strategies);
+                case ESpinMethod::WaitOnAddress:      return operationsFor<ESpinMethod::WaitOnAddress>     (lockStrategy, strategies);
+                default: THROW_EXCEPTION(std::invalid_argument, "Unsupported spin method '"s + std::to_string((uint64_t)spinMethod));
+            }
+        }
+
+        /** `SpinLock`'s adaptive & preemption aware sentinels have no runtime counterpart here -- and would otherwise be taken
+          * as (huge) cycle counts */
+        static void validateHardLockFallbackAfterCycles(uint64_t hardLockFallbackAfterCycles) {
+            if ( (hardLockFallbackAfterCycles == SpinLockAdaptiveHardLockFallback) ||
+                 (hardLockFallbackAfterCycles == SpinLockPreemptionAwareHardLockFallback) ) {
+                THROW_EXCEPTION(std::invalid_argument, "Unsupported hard lock fallback cycles '"s + std::to_string(hardLockFallbackAfterCycles) +
+                                "': adaptive & preemption aware fallbacks are only available on `SpinLock`");
+            }
+        }
+
+        template <typename _Enum, size_t _n>
+        static _Enum fromName(std::string_view name, const _Enum (&values)[_n], const char* const (&names)[_n], const char* what) {
+            for (size_t i=0; i<_n; i++) {
+                if (name == names[i]) {
+                    return values[i];
+                }
+            }
+            THROW_EXCEPTION(std::invalid_argument, "Unknown "s + what + " '" + std::string(name));
+        }
+
+        template <typename _Enum, size_t _n>
+        static const char* toName(_Enum value, const _Enum (&values)[_n], const char* const (&names)[_n]) {
+            for (size_t i=0; i<_n; i++) {
+                if (value == values[i]) {
+                    return names[i];
+                }
+            }
+            return "?";
+        }
+
+        const DynamicSpinLockOperations&   operations;
+        const ELockSpecializations         lockStrategy;
+        const ESpinMethod                  spinMethod;
+        const uint64_t                     hardLockFallbackAfterCycles;
+        alignas(Strategies::alignment) unsigned char specialization[Strategies::size];
+
+        DynamicSpinLock(std::tuple<ELockSpecializations, ESpinMethod, uint64_t> configuration)
+                : DynamicSpinLock(std::get<0>(configuration), std::get<1>(configuration), std::get<2>(configuration)) {}
+
+    public:
+
+        DynamicSpinLock(ELockSpecializations lockStrategy                = ELockSpecializations::Mutex,
+                        ESpinMethod          spinMethod                  = ESpinMethod::CPURelax,
+                        uint64_t             hardLockFallbackAfterCycles = NoHardLockFallback)
+                : operations(operationsFor(lockStrategy, spinMethod))
+                , lockStrategy(lockStrategy)
+                , spinMethod(spinMethod)
+                , hardLockFallbackAfterCycles(hardLockFallbackAfterCycles) {
+            validateHardLockFallbackAfterCycles(hardLockFallbackAfterCycles);
+            operations.construct(specialization);
+        }
+
+        /** builds from a "<lockStrategy>[:<spinMethod>[:<hardLockFallbackAfterCycles>]]" configuration string, like
+          * "Futex:CPURelax:1000000" or "RMWLight" -- where the names are the ones of the `ELockSpecializations` and
+          * `ESpinMethod` enumerations. Throws `std::invalid_argument` on unknown names and on cycle counts which are `SpinLock`
+          * sentinels: 1 (which is 'NoHardLockFallback' -- omit the field instead) and the adaptive & preemption aware ones */
+        explicit DynamicSpinLock(std::string_view configuration)
+                : DynamicSpinLock(parseConfiguration(configuration)) {}
+
+        /** builds from the configuration string (see above) in the 'environmentVariable', or 'defaultConfiguration' if unset */
+        static DynamicSpinLock fromEnvironment(const char* environmentVariable, std::string_view defaultConfiguration = "Mutex") {
+            const char* configuration = std::getenv(environmentVariable);
+            return DynamicSpinLock(configuration != nullptr ? std::string_view(configuration) : defaultConfiguration);
+        }
+
+        static std::tuple<ELockSpecializations, ESpinMethod, uint64_t> parseConfiguration(std::string_view configuration) {
+            ELockSpecializations lockStrategy                = ELockSpecializations::Mutex;
+            ESpinMethod          spinMethod                  = ESpinMethod::CPURelax;
+            uint64_t             hardLockFallbackAfterCycles = NoHardLockFallback;
+            size_t               field                       = 0;
+            std::string_view     remaining                   = configuration;
+            while (true) {
+                size_t           separator = remaining.find(':');
+                std::string_view value     = remaining.substr(0, separator);
+                switch (field++) {
+                    case 0:  lockStrategy = fromName(value, lockStrategies, lockStrategyNames, "lock strategy"); break;
+                    case 1:  spinMethod   = fromName(value, spinMethods,    spinMethodNames,   "spin method");   break;
+                    case 2: {
+                        std::string number(value);
+                        if ( number.empty() || (number.find_first_not_of("0123456789") != std::string::npos) ) {
+                            THROW_EXCEPTION(std::invalid_argument, "Invalid hard lock fallback cycles '"s + number);
+                        }
+                        errno = 0;
+                        hardLockFallbackAfterCycles = std::strtoull(number.c_str(), nullptr, 10);
+                        // 1 is 'NoHardLockFallback' -- which is expressed by omitting this field
+                        if ( (errno == ERANGE) || (hardLockFallbackAfterCycles == NoHardLockFallback) ) {
+                            THROW_EXCEPTION(std::invalid_argument, "Invalid hard lock fallback cycles '"s + number + "' -- "
+                                            "omit the field for no hard lock fallback");
+                        }
+                        validateHardLockFallbackAfterCycles(hardLockFallbackAfterCycles);
+                        break;
+                    }
+                    default: THROW_EXCEPTION(std::invalid_argument, "Too many fields in lock configuration '"s + std::string(configuration));
+                }
+                if (separator == std::string_view::npos) {
+                    break;
+                }
+                remaining.remove_prefix(separator+1);
+            }
+            return {lockStrategy, spinMethod, hardLockFallbackAfterCycles};
+        }
+
+        DynamicSpinLock(const DynamicSpinLock&)            = delete;
+        DynamicSpinLock& operator=(const DynamicSpinLock&) = delete;
+
+        ~DynamicSpinLock() {
+            operations.destruct(specialization);
+        }
+
+        /** returns the configuration string for this lock, suitable for logging the variant being tested */
+        std::string configuration() const {
+            std::stringstream c;
+            c << toName(lockStrategy, lockStrategies, lockStrategyNames) << ':' << toName(spinMethod, spinMethods, spinMethodNames);
+            if (hardLockFallbackAfterCycles != NoHardLockFallback) {
+                c << ':' << hardLockFallbackAfterCycles;
+            }
+            return c.str();
+        }
+
+        inline void lock() {
+            operations.lock(specialization, hardLockFallbackAfterCycles);
+        }
+
+        inline bool try_lock() {
+            return operations.try_lock(specialization);
+        }
+
+        inline void unlock() {
+            operations.unlock(specialization);
+        }
+
+    };
+}
+
+#endif /* MTL_THREAD_DynamicSpinLock_hpp_ */
@@ -0,0 +1,160 @@
+/*! \file FlatCombiner.hpp
+    \brief Flat combining: runs small critical sections in batches, on whichever thread holds the lock.
+
+    For tiny critical sections (counters, small maps, free lists...), where handing the lock & the data over among cores costs
+    more than the operations themselves.
+*/
+
+#ifndef MTL_THREAD_FlatCombiner_hpp_
+#define MTL_THREAD_FlatCombiner_hpp_
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "SpinLock.hpp"
+#include "ThreadSlotIndex.hpp"
+
+
+namespace MTL::thread {
+
+    /**
+     * FlatCombiner.hpp
+     * ================
+     *
+     * Guards a '_Data' instance, on which operations are run through 'apply()': instead of each thread taking the lock
+     * to run its own operation, threads publish it on their own slot and whoever gets the lock -- the "combiner" -- runs
+     * all pending operations in a single pass, while the data stays hot in its cache. Waiters only watch their own slot,
+     * so each operation costs O(1) cache line transfers, no matter how many threads contend.
+     *
+     * Each thread uses the slot given by its exclusive `ThreadSlotIndex` -- threads beyond 'ThreadSlots-1'
+     * simply take the lock and run their operations themselves. Operations' results (and exceptions) are delivered back
+     * to the calling thread, as if it had run them.
+     *
+    */
+    template<
+             /** the guarded data type */
+             typename             _Data,
+             /** how waiters spin on their slots -- `WaitOnAddress` lets them sleep until their operation is done */
+             ESpinMethod          _spinMethod   = ESpinMethod::CPURelax,
+             /** the combiner's lock strategy -- see @ref SpinLock */
+             ELockSpecializations _lockStrategy = ELockSpecializations::RMWLight>
+    class FlatCombiner {
+
+        /** how many times, at most, a combiner scans the slots while it keeps finding pending operations */
+        static constexpr unsigned maxCombiningPasses = 3;
+        static constexpr unsigned nSlots             = ThreadSlots-1;
+
+        /** a thread's published operation */
+        struct alignas(64) Slot {
+            std::atomic<bool>  pending = ATOMIC_VAR_INIT(false);      // set by the owner thread, cleared by the combiner once done
+            void             (*operation)(void* context, _Data& data);
+            void*              context;
+            std::exception_ptr exception;
+        };
+
+        SpinLock<_spinMethod, _lockStrategy> lock;
+        alignas(64) _Data                   data;
+        alignas(64) std::atomic<unsigned>   activeSlots = ATOMIC_VAR_INIT(0);   // slots above this were never used
+        Slot                                slots[nSlots];
+
+        /** runs all pending operations -- must be called with 'lock' held */
+        inline void combine() {
+            unsigned nActiveSlots = activeSlots.load(std::memory_order_acquire);
+            for (unsigned pass=0; pass<maxCombiningPasses; pass++) {
+                bool found = false;
+                for (unsigned i=0; i<nActiveSlots; i++) {
+                    Slot& slot = slots[i];
+                    if (slot.pending.load(std::memory_order_acquire)) {
+                        try {
+                            slot.operation(slot.context, data);
+                        } catch (...) {
+                            slot.exception = std::current_exception();
+                        }
+                        slot.pending.store(false, std::memory_order_release);
+                        found = true;
+                    }
+                }
+                if (!found) {
+                    break;
+                }
+            }
+        }
+
+        /** publishes 'operation' on this thread's slot and returns once someone -- possibly us -- ran it */
+        inline void post(unsigned slotIndex, void* context, void (*operation)(void* context, _Data& data)) {
+            Slot& slot = slots[slotIndex];
+            slot.context   = context;
+            slot.operation = operation;
+            // make sure combiners will scan our slot
+            unsigned nActiveSlots = activeSlots.load(std::memory_order_relaxed);
+            while ( (nActiveSlots <= slotIndex) &&
+                    (!activeSlots.compare_exchange_weak(nActiveSlots, slotIndex+1, std::memory_order_release, std::memory_order_relaxed)) );
+            slot.pending.store(true, std::memory_order_release);
+
+            while (slot.pending.load(std::memory_order_acquire)) {
+                if (lock.try_lock()) {
+                    combine();          // our own operation included
+                    lock.unlock();
+                } else {
+                    helperESpinMethod<_spinMethod>(slot.pending, true);
+                }
+            }
+            helperESpinMethodWaitEnded<_spinMethod>();
+
+            if (slot.exception) {
+                std::exception_ptr exception = std::move(slot.exception);
+                slot.exception = nullptr;
+                std::rethrow_exception(exception);
+            }
+        }
+
+    public:
+
+        template <typename... _Args>
+        FlatCombiner(_Args&&... args)
+                : data(std::forward<_Args>(args)...) {}
+
+        /** runs 'operation(data)' -- where 'data' is a '_Data&' -- with exclusive access to the guarded data, returning its
+          * result. The operation may run on another thread, so it should only touch the data and what it captured */
+        template <typename _Operation>
+        inline auto apply(_Operation&& operation) -> decltype(operation(std::declval<_Data&>())) {
+            typedef decltype(operation(std::declval<_Data&>())) Result;
+            typedef std::remove_reference_t<_Operation>         Operation;
+
+            if (!threadSlotIndex.exclusive) {
+                std::lock_guard<SpinLock<_spinMethod, _lockStrategy>> guard(lock);
+                return operation(data);
+            }
+
+            if constexpr (std::is_void_v<Result>) {
+                post(threadSlotIndex.index, const_cast<void*>(static_cast<const void*>(&operation)), [](void* context, _Data& data) {
+                    (*static_cast<Operation*>(context))(data);
+                });
+            } else {
+                // references are returned through 'std::reference_wrapper's
+                typedef std::conditional_t<std::is_reference_v<Result>, std::reference_wrapper<std::remove_reference_t<Result>>, Result> StoredResult;
+                struct Call {
+                    Operation*                  operation;
+                    std::optional<StoredResult> result;
+                } call{&operation, std::nullopt};
+                post(threadSlotIndex.index, &call, [](void* context, _Data& data) {
+                    Call* call = static_cast<Call*>(context);
+                    call->result.emplace((*call->operation)(data));
+                });
+                if constexpr (std::is_reference_v<Result>) {
+                    return call.result->get();
+                } else {
+                    return std::move(*call.result);
+                }
+            }
+        }
+
+    };
+}
+
+#endif /* MTL_THREAD_FlatCombiner_hpp_ */
@@ -12,18 +12,254 @@
 #define MTL_THREAD_FutexAdapter_hpp_
 
 #include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <ctime>
+#include <system_error>
+#include <type_traits>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
 #include <linux/futex.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/stat.h>
 #include <syscall.h>
 #include <unistd.h>
 
 namespace MTL::thread::FutexAdapter {
 
-	inline int wait(std::atomic<int32_t>& id) {
-		return ::syscall(SYS_futex, static_cast<void*>(&id), FUTEX_WAIT_PRIVATE, 0, nullptr, nullptr, 0);
+	/** the futex operation 'op', restricted to this process -- which is cheaper -- unless '_processShared' is given, in which
+	  * case the futex may live in memory shared among processes (mmap'ed with MAP_SHARED, for instance) */
+	template <bool _processShared>
+	constexpr int futexOp(int op) {
+		return _processShared ? op : (op | FUTEX_PRIVATE_FLAG);
 	}
 
-	inline int wake(std::atomic<int32_t>& id) {
-		return ::syscall(SYS_futex, static_cast<void*>(&id), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+	/** sleeps while 'id' holds 'expected' -- or until woken up, or a signal arrives */
+	template <bool _processShared = false>
+	inline int wait(std::atomic<int32_t>& id, int32_t expected = 0) {
+		return ::syscall(SYS_futex, static_cast<void*>(&id), futexOp<_processShared>(FUTEX_WAIT), expected, nullptr, nullptr, 0);
+	}
+
+	/** like 'wait()', but giving up -- returning -1 with 'errno' set to ETIMEDOUT -- once the absolute 'deadline', measured
+	  * by CLOCK_MONOTONIC, is reached. Uses FUTEX_WAIT_BITSET, as plain FUTEX_WAIT only takes relative timeouts */
+	template <bool _processShared = false>
+	inline int waitUntil(std::atomic<int32_t>& id, int32_t expected, const struct timespec& deadline) {
+		return ::syscall(SYS_futex, static_cast<void*>(&id), futexOp<_processShared>(FUTEX_WAIT_BITSET), expected, &deadline, nullptr, FUTEX_BITSET_MATCH_ANY);
+	}
+
+	/** converts any 'std::chrono' 'deadline' to 'std::chrono::steady_clock' -- which, on Linux, is CLOCK_MONOTONIC */
+	template <typename _Clock, typename _Duration>
+	inline std::chrono::steady_clock::time_point toSteadyDeadline(const std::chrono::time_point<_Clock, _Duration>& deadline) {
+		if constexpr (std::is_same_v<_Clock, std::chrono::steady_clock>) {
+			return std::chrono::time_point_cast<std::chrono::steady_clock::duration>(deadline);
+		} else {
+			return std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(deadline - _Clock::now());
+		}
+	}
+
+	/** converts any 'std::chrono' 'deadline' to the CLOCK_MONOTONIC absolute time expected by 'waitUntil()' */
+	template <typename _Clock, typename _Duration>
+	inline struct timespec toMonotonicDeadline(const std::chrono::time_point<_Clock, _Duration>& deadline) {
+		auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(toSteadyDeadline(deadline).time_since_epoch()).count();
+		if (nanoseconds < 0) {
+			nanoseconds = 0;
+		}
+		return {static_cast<time_t>(nanoseconds / 1'000'000'000), static_cast<long>(nanoseconds % 1'000'000'000)};
+	}
+
+	/** wakes up to 'count' threads sleeping on 'id' */
+	template <bool _processShared = false>
+	inline int wake(std::atomic<int32_t>& id, int32_t count = 1) {
+		return ::syscall(SYS_futex, static_cast<void*>(&id), futexOp<_processShared>(FUTEX_WAKE), count, nullptr, nullptr, 0);
+	}
+
+	/** the kernel's id for the calling thread -- as used by PI & robust futexes -- cached per thread and forgotten on 'fork()' */
+	inline int32_t threadId() {
+		static thread_local int32_t tid = 0;
+		if (tid == 0) {
+			static const bool forkHandlerRegistered = [] {
+				// the child's forking thread inherits its parent's cache
+				return pthread_atfork(nullptr, nullptr, [] { tid = 0; }) == 0;
+			}();
+			(void)forkHandlerRegistered;
+			tid = static_cast<int32_t>(::syscall(SYS_gettid));
+		}
+		return tid;
+	}
+
+	/** identifies the calling process' PID namespace -- the inode of '/proc/self/ns/pid' -- or 0 if it can't be told.
+	  * Read once per process and forgotten on 'fork()', as the child may be on a new namespace */
+	inline uint32_t pidNamespaceId() {
+		static std::atomic<int64_t> namespaceId = -1;
+		static const bool forkHandlerRegistered = [] {
+			return pthread_atfork(nullptr, nullptr, [] { namespaceId.store(-1, std::memory_order_relaxed); }) == 0;
+		}();
+		(void)forkHandlerRegistered;
+		int64_t id = namespaceId.load(std::memory_order_relaxed);
+		if (id == -1) {
+			struct stat namespaceStat;
+			id = (::stat("/proc/self/ns/pid", &namespaceStat) == 0) ? static_cast<uint32_t>(namespaceStat.st_ino) : 0;
+			namespaceId.store(id, std::memory_order_relaxed);
+		}
+		return static_cast<uint32_t>(id);
+	}
+
+	/** false if thread 'tid' is gone or is a zombie -- dead, but not yet reaped by its parent process. Based on 'kill()' &
+	  * '/proc', so it only sees threads on our PID namespace -- and can't tell a reused tid from its previous owner */
+	inline bool isThreadAlive(int32_t tid) {
+		if ( (::kill(tid, 0) == -1) && (errno == ESRCH) ) {
+			return false;
+		}
+		// '/proc/<tid>/stat' is "<tid> (<name>) <state> ..." -- and <name> may contain ')'
+		char path[32];
+		char stat[512];
+		snprintf(path, sizeof(path), "/proc/%d/stat", tid);
+		int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+		if (fd == -1) {
+			return errno != ENOENT;
+		}
+		ssize_t length = ::read(fd, stat, sizeof(stat)-1);
+		::close(fd);
+		if (length <= 0) {
+			return true;
+		}
+		stat[length] = '\0';
+		const char* nameEnd = strrchr(stat, ')');
+		return (nameEnd == nullptr) || (nameEnd[1] == '\0') || ( (nameEnd[2] != 'Z') && (nameEnd[2] != 'X') );
+	}
+
+	/** wakes up to 'nWake' threads sleeping on 'from' and moves up to 'nRequeue' of the remaining ones to sleep on 'to' --
+	  * provided 'from' still holds 'expected' (otherwise, fails with EAGAIN) */
+	inline int requeue(std::atomic<int32_t>& from, int32_t expected, int32_t nWake, std::atomic<int32_t>& to, int32_t nRequeue) {
+		return ::syscall(SYS_futex, static_cast<void*>(&from), FUTEX_CMP_REQUEUE_PRIVATE, nWake, reinterpret_cast<void*>(static_cast<intptr_t>(nRequeue)), static_cast<void*>(&to), expected);
+	}
+
+	/** 'futex_waitv()' takes, at most, this many futexes */
+	constexpr unsigned WAIT_ANY_MAX = 128;
+
+	/** one of the futexes given to 'waitAny()' and the value it should hold for us to sleep on it */
+	struct WaitAnyEntry {
+		std::atomic<int32_t>* word;
+		int32_t               expected;
+	};
+
+	// 'futex_waitv()' is syscall 449 on all architectures -- which older headers don't define
+#ifdef SYS_futex_waitv
+	constexpr long SYS_futex_waitv_NUMBER = SYS_futex_waitv;
+#else
+	constexpr long SYS_futex_waitv_NUMBER = 449;
+#endif
+	// 'futex_waitv()''s size flag came along with it, in the same Linux 5.16 headers
+#ifndef FUTEX_32
+#define FUTEX_32 2
+#endif
+
+	/** the same layout as Linux 5.16's 'struct futex_waitv', which older headers don't have */
+	struct FutexWaitv {
+		uint64_t val;
+		uint64_t uaddr;
+		uint32_t flags;
+		uint32_t reserved;
+	};
+
+	/** tells if the running kernel has 'futex_waitv()' (Linux 5.16+) -- checked only once per process */
+	inline bool isWaitvAvailable() {
+		static const bool waitvAvailable = [] {
+			// with no futexes, an available 'futex_waitv()' fails with EINVAL -- anything else (ENOSYS, or EPERM from a
+			// seccomp filter unaware of it) means it can't be used
+			return (::syscall(SYS_futex_waitv_NUMBER, nullptr, 0, 0, nullptr, 0) == -1) && (errno == EINVAL);
+		}();
+		return waitvAvailable;
+	}
+
+	/** state for the 'waitAny()' fallback on kernels lacking 'futex_waitv()': waiters sleep on a single, process wide,
+	  * 'sequence', which 'wakeAny()' bumps -- and wakes -- whenever there is someone sleeping there */
+	struct alignas(64) WaitAnyFallbackState {
+		std::atomic<int32_t>             sequence = 0;
+		alignas(64) std::atomic<int32_t> waiters  = 0;
+	};
+	inline WaitAnyFallbackState waitAnyFallbackState;
+
+	/** returns the index of the first entry no longer holding its expected value -- or -1 if all of them still do */
+	inline int changedEntry(const WaitAnyEntry* entries, unsigned count) {
+		for (unsigned i=0; i<count; i++) {
+			if (entries[i].word->load(std::memory_order_acquire) != entries[i].expected) {
+				return i;
+			}
+		}
+		return -1;
+	}
+
+	/** 'waitAny()' through 'futex_waitv()' */
+	inline int waitAnyWaitv(const WaitAnyEntry* entries, unsigned count, const struct timespec* deadline) {
+		FutexWaitv waiters[WAIT_ANY_MAX];
+		for (unsigned i=0; i<count; i++) {
+			waiters[i] = {static_cast<uint64_t>(static_cast<uint32_t>(entries[i].expected)),
+			              reinterpret_cast<uint64_t>(entries[i].word),
+			              FUTEX_32 | FUTEX_PRIVATE_FLAG,
+			              0};
+		}
+		int woken = ::syscall(SYS_futex_waitv_NUMBER, waiters, count, 0, deadline, CLOCK_MONOTONIC);
+		if ( (woken == -1) && (errno == EAGAIN) ) {
+			// some futex didn't hold its expected value -- tell which one
+			int changed = changedEntry(entries, count);
+			if (changed >= 0) {
+				return changed;
+			}
+			errno = EINTR;	// it got back to its expected value: let the caller recheck
+		}
+		return woken;
+	}
+
+	/** 'waitAny()' through 'waitAnyFallbackState' -- which only works if the futexes are signaled through 'wakeAny()' */
+	inline int waitAnyFallback(const WaitAnyEntry* entries, unsigned count, const struct timespec* deadline) {
+		waitAnyFallbackState.waiters.fetch_add(1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);	// pairs with the one in 'wakeAny()': either we see the new value or it sees us
+		int32_t sequence = waitAnyFallbackState.sequence.load(std::memory_order_acquire);
+		int     changed  = changedEntry(entries, count);
+		if (changed < 0) {
+			int result = deadline ? waitUntil(waitAnyFallbackState.sequence, sequence, *deadline)
+			                      : wait(waitAnyFallbackState.sequence, sequence);
+			int waitErrno = errno;
+			changed = changedEntry(entries, count);
+			if (changed < 0) {
+				// other futexes were signaled, a signal arrived or we timed out
+				errno = ( (result == -1) && (waitErrno == ETIMEDOUT) ) ? ETIMEDOUT : EINTR;
+			}
+		}
+		waitAnyFallbackState.waiters.fetch_sub(1, std::memory_order_relaxed);
+		return changed;
+	}
+
+	/** sleeps until any of the 'count' (up to 'WAIT_ANY_MAX') 'entries' is woken up -- or is found not to hold its expected
+	  * value -- returning its index. Uses Linux 5.16's 'futex_waitv()' or, on older kernels, a shared wake word, in which
+	  * case the futexes must be signaled through 'wakeAny()'. Returns -1 on errors: EINTR for signals and spurious wake
+	  * ups -- callers should recheck their conditions, as with any futex wait -- and ETIMEDOUT when the optional absolute
+	  * CLOCK_MONOTONIC 'deadline' is reached */
+	inline int waitAny(const WaitAnyEntry* entries, unsigned count, const struct timespec* deadline = nullptr) {
+		if ( (count == 0) || (count > WAIT_ANY_MAX) ) {
+			errno = EINVAL;
+			return -1;
+		}
+		return isWaitvAvailable() ? waitAnyWaitv(entries, count, deadline)
+		                          : waitAnyFallback(entries, count, deadline);
+	}
+
+	/** like 'wake()', but also reaches the threads in 'waitAny()' -- to be used, after changing the value of 'id', by the
+	  * producers of futexes others may wait for along with others. When no one uses the 'waitAny()' fallback, the extra
+	  * cost is just a fence and a load */
+	inline int wakeAny(std::atomic<int32_t>& id, int32_t count = 1) {
+		int woken = wake(id, count);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (waitAnyFallbackState.waiters.load(std::memory_order_relaxed) > 0) {
+			waitAnyFallbackState.sequence.fetch_add(1, std::memory_order_release);
+			wake(waitAnyFallbackState.sequence, INT_MAX);
+		}
+		return woken;
 	}
 
 /*	inline int sys_futex(void* addr, std::int32_t op, std::int32_t x) {
@@ -43,34 +279,342 @@ namespace MTL::thread::FutexAdapter {
 
 namespace MTL::thread {
 
-	struct Futex {
+	/** Futex based mutex. When '_processShared', it may be placed in memory shared among processes -- see `SharedFutex` */
+	template <bool _processShared = false>
+	struct BasicFutex {
 
 		alignas(64) std::atomic<int32_t> futexWord   = 0;
 
 		inline void lock() {
 
 			int32_t value = 0;
-			while (!futexWord.compare_exchange_strong(value, 1, std::memory_order_release, std::memory_order_relaxed)) {
-				if (value == 2 || futexWord.exchange(2, std::memory_order_relaxed)) {
-					do {
-						::syscall(SYS_futex, static_cast<void*>(&futexWord), FUTEX_WAIT_PRIVATE, 2, NULL, NULL, 0);
-					} while (futexWord.exchange(2, std::memory_order_relaxed));
+			if (!futexWord.compare_exchange_strong(value, 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+				if (value == 2 || futexWord.exchange(2, std::memory_order_acquire)) {
+					lockContended();
 				}
-				break;
-				//value = 0;
 			}
 
 		}
 
+		/** locks, assuming there may be other threads sleeping on 'futexWord' -- so our 'unlock()' will wake one of them */
+		inline void lockContended() {
+			while (futexWord.exchange(2, std::memory_order_acquire)) {
+				FutexAdapter::wait<_processShared>(futexWord, 2);
+			}
+		}
+
 		inline bool try_lock() {
 			int32_t value = 0;
-			return futexWord.compare_exchange_strong(value, 1, std::memory_order_relaxed, std::memory_order_relaxed);
+			return futexWord.compare_exchange_strong(value, 1, std::memory_order_acquire, std::memory_order_relaxed);
+		}
+
+		/** like 'lock()', but gives up (returning false) once the absolute CLOCK_MONOTONIC 'deadline' is reached */
+		inline bool lockUntil(const struct timespec& deadline) {
+			int32_t value = 0;
+			if (futexWord.compare_exchange_strong(value, 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+				return true;
+			}
+			while (futexWord.exchange(2, std::memory_order_acquire)) {
+				if ( (FutexAdapter::waitUntil<_processShared>(futexWord, 2, deadline) == -1) && (errno == ETIMEDOUT) ) {
+					// we leave the word marked as contended: at most, it costs the holder a needless wake up
+					return false;
+				}
+			}
+			return true;
+		}
+
+		template <typename _Clock, typename _Duration>
+		inline bool try_lock_until(const std::chrono::time_point<_Clock, _Duration>& deadline) {
+			return try_lock() || lockUntil(FutexAdapter::toMonotonicDeadline(deadline));
+		}
+
+		template <typename _Rep, typename _Period>
+		inline bool try_lock_for(const std::chrono::duration<_Rep, _Period>& timeout) {
+			return try_lock() || lockUntil(FutexAdapter::toMonotonicDeadline(std::chrono::steady_clock::now() + timeout));
 		}
 
 		inline void unlock() {
-			if (futexWord.exchange(0, std::memory_order_relaxed) == 2) {
-				::syscall(SYS_futex, static_cast<void*>(&futexWord), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+			if (futexWord.exchange(0, std::memory_order_release) == 2) {
+				FutexAdapter::wake<_processShared>(futexWord);
+			}
+		}
+
+	};
+
+	typedef BasicFutex<false> Futex;
+	/** `Futex` for memory shared among processes (MAP_SHARED mappings): uses the non private futex operations, which lets the
+	  * kernel match waiters & wakers by the physical page, at the cost of a slower futex hash lookup. No pointers are kept, so
+	  * each process may map it at a different address -- but a process dying while holding it leaves it locked forever: see
+	  * `RobustFutex` for that */
+	typedef BasicFutex<true>  SharedFutex;
+
+	/** Process shared futex surviving the death of its owner: the word holds the owner's thread id (plus the kernel's
+	  * FUTEX_WAITERS bit, when there may be sleepers) -- like PI & robust futexes do -- so waiters sleeping for longer than
+	  * 'livenessCheckNs' check if the owner is still alive and, if it isn't, take the lock over, with 'ownerDied()' telling
+	  * the guarded data may be inconsistent -- the analogous of pthread's EOWNERDEAD. Linux only reports dead owners through
+	  * the per thread robust list, already taken by glibc for its own robust mutexes, so the liveness is checked with 'kill()'
+	  * & '/proc' -- which only see threads on the waiter's PID namespace. So owners publish their namespace along with their
+	  * tid and waiters on other namespaces never take the lock over: they wait for it to be unlocked, as with `SharedFutex`.
+	  * Liveness can't tell the dead owner from a new thread reusing its tid: if that happens before any waiter checks, the
+	  * lock is never taken over. Only sleeping waiters check, so spinners must end up in 'lock()'. Like `PIFutex`, must be
+	  * unlocked by the locking thread */
+	struct RobustFutex {
+
+		static constexpr long livenessCheckNs = 50'000'000;
+
+		alignas(64) std::atomic<int32_t> futexWord         = 0;	// 0 or the owner's tid -- possibly with 'FUTEX_WAITERS'
+		std::atomic<uint64_t>            ownerIdentity     = 0;	// (pidNamespaceId() << 32) | tid, published by the owner right after acquiring
+		bool                             previousOwnerDied = false;	// only accessed by the lock holder
+
+		inline void lock() {
+			if (!try_lock()) {
+				lockContended(nullptr);
+			}
+		}
+
+		inline bool try_lock() {
+			int32_t value = 0;
+			if (futexWord.compare_exchange_strong(value, FutexAdapter::threadId(), std::memory_order_acquire, std::memory_order_relaxed)) {
+				acquired(false);
+				return true;
+			}
+			return false;
+		}
+
+		/** like 'lock()', but gives up (returning false) once the absolute CLOCK_MONOTONIC 'deadline' is reached */
+		inline bool lockUntil(const struct timespec& deadline) {
+			return try_lock() || lockContended(&deadline);
+		}
+
+		template <typename _Clock, typename _Duration>
+		inline bool try_lock_until(const std::chrono::time_point<_Clock, _Duration>& deadline) {
+			return lockUntil(FutexAdapter::toMonotonicDeadline(deadline));
+		}
+
+		template <typename _Rep, typename _Period>
+		inline bool try_lock_for(const std::chrono::duration<_Rep, _Period>& timeout) {
+			return try_lock_until(std::chrono::steady_clock::now() + timeout);
+		}
+
+		inline void unlock() {
+			int32_t value = FutexAdapter::threadId();
+			if (!futexWord.compare_exchange_strong(value, 0, std::memory_order_release, std::memory_order_relaxed)) {
+				// 'FUTEX_WAITERS' is set: the woken waiter sets it again, as there may be others
+				futexWord.store(0, std::memory_order_release);
+				FutexAdapter::wake<true>(futexWord);
+			}
+		}
+
+		/** tells the lock holder if the lock was taken over from an owner which died holding it */
+		inline bool ownerDied() const {
+			return previousOwnerDied;
+		}
+
+	private:
+
+		inline void acquired(bool ownerDied) {
+			previousOwnerDied = ownerDied;
+			ownerIdentity.store((static_cast<uint64_t>(FutexAdapter::pidNamespaceId()) << 32) | static_cast<uint32_t>(FutexAdapter::threadId()),
+			                    std::memory_order_release);
+		}
+
+		/** tells if 'owner' may be taken for dead: it published being on our PID namespace -- where 'isThreadAlive()' sees it
+		  * -- and it is gone. Owners that didn't publish their identity yet are assumed alive */
+		inline bool isOwnerDead(int32_t owner) {
+			uint64_t identity    = ownerIdentity.load(std::memory_order_acquire);
+			uint32_t namespaceId = FutexAdapter::pidNamespaceId();
+			return (namespaceId != 0) &&
+			       (static_cast<int32_t>(identity & 0xFFFFFFFFu) == owner) &&
+			       (static_cast<uint32_t>(identity >> 32) == namespaceId) &&
+			       !FutexAdapter::isThreadAlive(owner);
+		}
+
+		inline bool lockContended(const struct timespec* deadline) {
+			const int32_t tid = FutexAdapter::threadId();
+			for (;;) {
+				int32_t value = futexWord.load(std::memory_order_relaxed);
+				if ((value & FUTEX_TID_MASK) == 0) {
+					// free -- as the unlocker cleared 'FUTEX_WAITERS', we must assume others are sleeping
+					if (futexWord.compare_exchange_weak(value, tid | FUTEX_WAITERS, std::memory_order_acquire, std::memory_order_relaxed)) {
+						acquired(false);
+						return true;
+					}
+					continue;
+				}
+				if ( ((value & FUTEX_WAITERS) == 0) &&
+				     (!futexWord.compare_exchange_weak(value, value | FUTEX_WAITERS, std::memory_order_relaxed, std::memory_order_relaxed)) ) {
+					continue;
+				}
+				value |= FUTEX_WAITERS;
+				// sleep, waking up every 'livenessCheckNs' to check the owner
+				struct timespec wakeUp;
+				clock_gettime(CLOCK_MONOTONIC, &wakeUp);
+				wakeUp.tv_nsec += livenessCheckNs;
+				if (wakeUp.tv_nsec >= 1'000'000'000) {
+					wakeUp.tv_sec  += 1;
+					wakeUp.tv_nsec -= 1'000'000'000;
+				}
+				bool deadlineFirst = (deadline != nullptr) &&
+				                     ( (deadline->tv_sec < wakeUp.tv_sec) || ( (deadline->tv_sec == wakeUp.tv_sec) && (deadline->tv_nsec <= wakeUp.tv_nsec) ) );
+				if ( (FutexAdapter::waitUntil<true>(futexWord, value, deadlineFirst ? *deadline : wakeUp) == -1) && (errno == ETIMEDOUT) ) {
+					if (deadlineFirst) {
+						return false;
+					}
+					if (isOwnerDead(value & FUTEX_TID_MASK)) {
+						// take the lock over -- unless another waiter did it first or the owner managed to unlock
+						if (futexWord.compare_exchange_strong(value, tid | FUTEX_WAITERS, std::memory_order_acquire, std::memory_order_relaxed)) {
+							acquired(true);
+							return true;
+						}
+					}
+				}
+			}
+		}
+
+	};
+
+	/** Priority inheritance futex: the word holds the owner's thread id, so the kernel may boost the priority of a preempted
+	  * owner up to the priority of its highest waiter -- sparing SCHED_FIFO / SCHED_RR waiters from priority inversions.
+	  * Uncontended operations never leave user space, but 'unlock()' must be called by the thread that called 'lock()' */
+	struct PIFutex {
+
+		alignas(64) std::atomic<int32_t> futexWord   = 0;	// 0 or the owner's tid -- possibly with FUTEX_WAITERS set by the kernel
+
+		/** throws 'std::system_error' if the kernel refuses to queue us -- EDEADLK if we already hold the lock, ENOMEM, ... --
+		  * as returning would let us in with the lock taken by someone else. An owner found to be gone (ESRCH or EINVAL with
+		  * a dead tid on the word -- as when a thread exits, or the process forks, while holding it) has the lock taken over */
+		inline void lock() {
+			while (!try_lock()) {
+				// the kernel queues us by priority and sets 'futexWord' to our tid once it hands the lock over
+				if (::syscall(SYS_futex, static_cast<void*>(&futexWord), FUTEX_LOCK_PI_PRIVATE, 0, nullptr, nullptr, 0) == 0) {
+					// syscalls are full barriers, but this makes the acquisition visible to the C++ memory model
+					futexWord.load(std::memory_order_acquire);
+					return;
+				}
+				int lockErrno = errno;
+				if ( (lockErrno == EINTR) || (lockErrno == EAGAIN) ) {
+					continue;	// interrupted or the owner is exiting: try again
+				}
+				int32_t value = futexWord.load(std::memory_order_relaxed);
+				int32_t owner = value & FUTEX_TID_MASK;
+				if ( ( (lockErrno == ESRCH) || (lockErrno == EINVAL) ) && (owner != FutexAdapter::threadId()) ) {
+					if (owner == 0) {
+						continue;	// unlocked meanwhile
+					}
+					if (!FutexAdapter::isThreadAlive(owner)) {
+						// with no owner to attach to, the kernel keeps no waiters: only our competitors, getting the same error, may race us
+						if (futexWord.compare_exchange_strong(value, FutexAdapter::threadId(), std::memory_order_acquire, std::memory_order_relaxed)) {
+							return;
+						}
+						continue;
+					}
+				}
+				throw std::system_error(lockErrno, std::generic_category(), "PIFutex::lock(): FUTEX_LOCK_PI failed");
+			}
+		}
+
+		inline bool try_lock() {
+			int32_t value = 0;
+			return futexWord.compare_exchange_strong(value, FutexAdapter::threadId(), std::memory_order_acquire, std::memory_order_relaxed);
+		}
+
+		inline void unlock() {
+			int32_t value = FutexAdapter::threadId();
+			if (!futexWord.compare_exchange_strong(value, 0, std::memory_order_release, std::memory_order_relaxed)) {
+				// there are waiters: the kernel hands the lock over to the highest priority one -- the syscall being a full barrier
+				::syscall(SYS_futex, static_cast<void*>(&futexWord), FUTEX_UNLOCK_PI_PRIVATE, 0, nullptr, nullptr, 0);
+			}
+		}
+
+	};
+
+	/** Condition variable for threads holding a `Futex` -- like `std::condition_variable`, spurious wake ups are possible,
+	  * so 'wait()' should be called in a loop checking the condition. 'notify_all()' wakes a single waiter and requeues the
+	  * others to sleep on the `Futex` itself, so they are woken, one by one, as it gets unlocked -- instead of all of them
+	  * waking up at once just to fight for it. Like `FutexEvent`, waiters are counted, so notifying with no one waiting
+	  * costs no syscall */
+	struct FutexCondition {
+
+		alignas(64) std::atomic<int32_t> sequence = 0;
+		std::atomic<int32_t>             waiters  = 0;
+		std::atomic<Futex*>              futex    = nullptr;	// the one used by the waiters -- the target of the requeues
+
+		/** 'futex' must be locked -- and it will be, again, when this returns */
+		inline void wait(Futex& futex) {
+			this->futex.store(&futex, std::memory_order_relaxed);
+			// the 'seq_cst's, here and on the notifications, ensure either they see us waiting or we see their new 'sequence'
+			waiters.fetch_add(1, std::memory_order_seq_cst);
+			int32_t currentSequence = sequence.load(std::memory_order_seq_cst);
+			futex.unlock();
+			FutexAdapter::wait(sequence, currentSequence);
+			waiters.fetch_sub(1, std::memory_order_relaxed);
+			// we may have been requeued to 'futex', whose 'unlock()' will only wake the next waiter if it is marked as contended
+			futex.lockContended();
+		}
+
+		inline void notify_one() {
+			sequence.fetch_add(1, std::memory_order_seq_cst);
+			if (waiters.load(std::memory_order_seq_cst) > 0) {
+				FutexAdapter::wake(sequence, 1);
+			}
+		}
+
+		inline void notify_all() {
+			int32_t currentSequence = sequence.fetch_add(1, std::memory_order_seq_cst) + 1;
+			if (waiters.load(std::memory_order_seq_cst) == 0) {
+				return;
+			}
+			Futex*  waitersFutex    = futex.load(std::memory_order_relaxed);
+			if (FutexAdapter::requeue(sequence, currentSequence, 1, waitersFutex->futexWord, INT_MAX) < 0) {
+				// another notification got in the way: just wake everybody
+				FutexAdapter::wake(sequence, INT_MAX);
+			}
+		}
+
+	};
+
+	/** Event to be waited for by any number of threads, either resetting automatically once a single waiter is released
+	  * (when '_autoReset' is true) or staying set -- releasing all current & future waiters -- until 'reset()' is called */
+	template <bool _autoReset = false>
+	struct FutexEvent {
+
+		alignas(64) std::atomic<int32_t> signaled = 0;
+		std::atomic<int32_t>             waiters  = 0;
+
+		FutexEvent(bool initiallySet = false)
+				: signaled(initiallySet ? 1 : 0) {}
+
+		inline void set() {
+			signaled.store(1, std::memory_order_seq_cst);
+			// the 'seq_cst's, here and on 'wait()', ensure either we see the waiter or it sees the event set
+			if (waiters.load(std::memory_order_seq_cst) > 0) {
+				FutexAdapter::wake(signaled, _autoReset ? 1 : INT_MAX);
+			}
+		}
+
+		inline void reset() {
+			signaled.store(0, std::memory_order_relaxed);
+		}
+
+		/** returns immediately (consuming the event, if '_autoReset') if it is set -- otherwise, returns false */
+		inline bool try_wait() {
+			if constexpr (_autoReset) {
+				int32_t expected = 1;
+				return signaled.compare_exchange_strong(expected, 0, std::memory_order_acquire, std::memory_order_relaxed);
+			} else {
+				return signaled.load(std::memory_order_acquire) == 1;
+			}
+		}
+
+		inline void wait() {
+			if (try_wait()) {
+				return;
+			}
+			waiters.fetch_add(1, std::memory_order_seq_cst);
+			while (!try_wait()) {
+				FutexAdapter::wait(signaled, 0);
 			}
+			waiters.fetch_sub(1, std::memory_order_relaxed);
 		}
 
 	};
@@ -0,0 +1,103 @@
+/*! \file NumaTopology.hpp
+    \brief Which NUMA node each CPU belongs to, as told by Linux's `/sys/devices/system/node`.
+
+    Hosts without that information (non-NUMA kernels, other OSes, containers hiding sysfs) are seen as having a single node.
+*/
+
+#ifndef MTL_THREAD_NumaTopology_hpp_
+#define MTL_THREAD_NumaTopology_hpp_
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <sched.h>
+
+
+namespace MTL::thread {
+
+    /**
+     * NumaTopology.hpp
+     * ================
+     *
+     * Detected once, at the first call to 'get()', so NUMA aware locks may cheaply map the CPU a thread is running on
+     * (from 'sched_getcpu()', served from the 'rseq' area on recent glibcs) to its node.
+     *
+    */
+    struct NumaTopology {
+
+        /** the number of nodes -- at least 1. Node ids are in [0, nNodes), but some of them may be offline, having no CPUs */
+        unsigned              nNodes;
+        /** cpuToNode[cpu] := node */
+        std::vector<unsigned> cpuToNode;
+
+        static const NumaTopology& get() {
+            static const NumaTopology topology;
+            return topology;
+        }
+
+        inline unsigned nodeOfCPU(int cpu) const {
+            return ( (cpu >= 0) && ((unsigned)cpu < cpuToNode.size()) ) ? cpuToNode[cpu] : 0;
+        }
+
+        /** the node of the CPU the calling thread is running on -- which may change as soon as this returns */
+        inline unsigned currentNode() const {
+            return nNodes == 1 ? 0 : nodeOfCPU(sched_getcpu());
+        }
+
+    private:
+
+        NumaTopology()
+                : nNodes(0) {
+            // node ids may have holes (offlined or hot-pluggable nodes), so the online ones are listed instead of probed
+            std::ifstream onlineNodes("/sys/devices/system/node/online");
+            std::string   nodes;
+            if (onlineNodes && std::getline(onlineNodes, nodes)) {
+                forEachInList(nodes, [this](unsigned node) {
+                    std::ifstream cpuList("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+                    std::string   cpus;
+                    if (!cpuList || !std::getline(cpuList, cpus)) {
+                        return;
+                    }
+                    forEachInList(cpus, [this, node](unsigned cpu) {
+                        if (cpuToNode.size() <= cpu) {
+                            cpuToNode.resize(cpu+1, 0);
+                        }
+                        cpuToNode[cpu] = node;
+                    });
+                    nNodes = std::max(nNodes, node+1);
+                });
+            }
+            if (nNodes == 0) {
+                nNodes = 1;
+                cpuToNode.clear();
+            }
+        }
+
+        /** calls 'callback(unsigned)' for each number on lists like "0-3,8-11" */
+        template <typename _Callback>
+        static void forEachInList(const std::string& list, _Callback&& callback) {
+            size_t position = 0;
+            while (position < list.size()) {
+                size_t      end   = list.find(',', position);
+                std::string range = list.substr(position, end == std::string::npos ? std::string::npos : end-position);
+                size_t      dash  = range.find('-');
+                try {
+                    unsigned first = std::stoul(range.substr(0, dash));
+                    unsigned last  = dash == std::string::npos ? first : std::stoul(range.substr(dash+1));
+                    for (unsigned number=first; number<=last; number++) {
+                        callback(number);
+                    }
+                } catch (const std::exception&) {
+                    // malformed (or empty, for memory only nodes) ranges are ignored
+                }
+                if (end == std::string::npos) {
+                    break;
+                }
+                position = end+1;
+            }
+        }
+    };
+}
+
+#endif /* MTL_THREAD_NumaTopology_hpp_ */
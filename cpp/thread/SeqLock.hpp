@@ -0,0 +1,206 @@
+/*! \file SeqLock.hpp
+    \brief Sequence lock for single writer (or few writers), many readers hot data.
+
+    Readers never write to shared memory: they copy the data optimistically and retry if a write happened meanwhile
+    (with metrics enabled, they only write to their own per-thread counters).
+*/
+
+#ifndef MTL_THREAD_SeqLock_hpp_
+#define MTL_THREAD_SeqLock_hpp_
+
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+#include "SpinLock.hpp"     // provides 'ESpinMethod' & 'helperESpinMethod()'
+
+
+namespace MTL::thread {
+
+    /** the reader metrics of a `SeqLock`, as seen by a thread -- see @ref SeqLockMetricsAdditionalFields */
+    struct alignas(64) SeqLockReaderMetricsShard {
+        std::atomic<uint64_t> readsCount, readRetriesCount;
+    };
+
+    /** the metrics of a `SeqLock`, aggregated from all its reader shards */
+    struct SeqLockMetricsSnapshot {
+        uint64_t readsCount, readRetriesCount, writesCount, writeSpinsCount;
+    };
+
+    /** conditional base class when using a seq lock with metrics DISABLED */
+    struct SeqLockMetricsNoAdditionalFields {};
+    /** conditional base class when using a seq lock with metrics ENABLED -- readers count on their own cache-line-padded
+      * shard (indexed by `ThreadSlotIndex`, as in @ref SpinLockShardedMetricsAdditionalFields), summed up on read, so
+      * they still never write to a line another reader writes to; writers count on their own (shared) cache line */
+    struct SeqLockMetricsAdditionalFields {
+        // metrics variables
+        SeqLockReaderMetricsShard         readerShards[ThreadSlots];
+        alignas(64) std::atomic<uint64_t> writesCount, writeSpinsCount;
+
+        inline void reset() {
+            for (SeqLockReaderMetricsShard& shard : readerShards) {
+                shard.readsCount.store(0, std::memory_order_relaxed);
+                shard.readRetriesCount.store(0, std::memory_order_relaxed);
+            }
+            writesCount.store(0, std::memory_order_relaxed);
+            writeSpinsCount.store(0, std::memory_order_relaxed);
+        }
+
+        /** adds 1 to the 'counter' on the current thread's shard */
+        inline void countRead(std::atomic<uint64_t> SeqLockReaderMetricsShard::* counter) {
+            const ThreadSlotIndex& shardIndex   = threadSlotIndex;
+            std::atomic<uint64_t>& shardCounter = readerShards[shardIndex.index].*counter;
+            if (__builtin_expect(shardIndex.exclusive, 1)) {
+                shardCounter.store(shardCounter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            } else {
+                shardCounter.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        inline SeqLockMetricsSnapshot aggregate() const {
+            SeqLockMetricsSnapshot snapshot = {};
+            for (const SeqLockReaderMetricsShard& shard : readerShards) {
+                snapshot.readsCount       += shard.readsCount.load(std::memory_order_relaxed);
+                snapshot.readRetriesCount += shard.readRetriesCount.load(std::memory_order_relaxed);
+            }
+            snapshot.writesCount     = writesCount.load(std::memory_order_relaxed);
+            snapshot.writeSpinsCount = writeSpinsCount.load(std::memory_order_relaxed);
+            return snapshot;
+        }
+
+        inline void debugMetrics(stringstream& c) {
+            SeqLockMetricsSnapshot snapshot = aggregate();
+            c << "readsCount="       << snapshot.readsCount       << ", "
+                 "readRetriesCount=" << snapshot.readRetriesCount << ", "
+                 "writesCount="      << snapshot.writesCount      << ", "
+                 "writeSpinsCount="  << snapshot.writeSpinsCount;
+        }
+    };
+
+    /**
+     * SeqLock.hpp
+     * ===========
+     *
+     * Guards a trivially copyable '_T' with a sequence counter: writers make it odd while writing and even again when
+     * done; readers copy the data, then check the counter was even and didn't change -- retrying otherwise.
+     * Reads never wait for one another and never bounce the cache line between readers, so this is the way to go for
+     * data with one writer and dozens of readers able to simply retry (market snapshots, configuration blocks, ...).
+     * Concurrent writers are serialized by spinning with the given 'ESpinMethod'.
+     *
+    */
+    template<
+             /** the guarded type -- must be trivially copyable, since readers may copy it while it is being written */
+             typename    _T,
+             /** how writers spin while another writer holds the lock (and how readers spin while a write is in progress) */
+             ESpinMethod _spinMethod = ESpinMethod::CPURelax,
+             /** when true, provides some operational metrics:
+               *   - readsCount / readRetriesCount
+               *   - writesCount / writeSpinsCount
+               * -- see 'metricsSnapshot()' --
+               * at the extra cost of readers incrementing a counter on their own, per thread, cache line */
+             bool        _opMetrics  = false>
+    class SeqLock
+              : std::conditional<_opMetrics, SeqLockMetricsAdditionalFields, SeqLockMetricsNoAdditionalFields>::type {
+
+        static_assert(std::is_trivially_copyable<_T>::value, "'SeqLock' requires a trivially copyable type");
+
+        static constexpr bool doCollectStandardMetrics = _opMetrics;
+
+        alignas(64) std::atomic<uint32_t> sequence = ATOMIC_VAR_INIT(0);
+        _T                                data;
+
+    public:
+
+        SeqLock(const _T& initialValue = _T())
+                : data(initialValue) {
+            if constexpr (doCollectStandardMetrics) {
+                SeqLockMetricsAdditionalFields::reset();
+            }
+        }
+
+        inline void issueDebugMessage(string message) {
+            stringstream c;
+            c << "MTL::SeqLock: " << message << ": {";
+            if constexpr (doCollectStandardMetrics) {
+                SeqLockMetricsAdditionalFields::debugMetrics(c);
+            }
+            c << "}\n";
+            std::cerr << c.str() << std::flush;
+        }
+
+        /** copies the guarded data into 'value', retrying until a consistent copy is made */
+        inline void read(_T& value) const {
+            uint32_t before;
+            uint32_t after;
+            if constexpr (doCollectStandardMetrics) {
+                const_cast<SeqLock*>(this)->countRead(&SeqLockReaderMetricsShard::readsCount);
+            }
+            while (true) {
+                before = sequence.load(std::memory_order_acquire);
+                if ( (before & 1) == 0 ) {
+                    std::memcpy(&value, &data, sizeof(_T));
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    after = sequence.load(std::memory_order_relaxed);
+                    if (before == after) {
+                        helperESpinMethodWaitEnded<_spinMethod>();
+                        return;
+                    }
+                }
+                if constexpr (doCollectStandardMetrics) {
+                    const_cast<SeqLock*>(this)->countRead(&SeqLockReaderMetricsShard::readRetriesCount);
+                }
+                // a write is in progress: wait for it to end -- if it had already ended, retry at once
+                if (before & 1) {
+                	helperESpinMethod<_spinMethod>(sequence, before);
+                }
+            }
+        }
+
+        /** sums up the metrics of all reader shards -- may be called from any thread, at any time. Requires '_opMetrics' */
+        inline SeqLockMetricsSnapshot metricsSnapshot() const {
+            static_assert(doCollectStandardMetrics, "'metricsSnapshot()' requires the '_opMetrics' template parameter to be true");
+            return SeqLockMetricsAdditionalFields::aggregate();
+        }
+
+        inline _T read() const {
+            _T value;
+            read(value);
+            return value;
+        }
+
+        /** replaces the guarded data with 'value' */
+        inline void write(const _T& value) {
+            update([&value](_T& data) {
+                data = value;
+            });
+        }
+
+        /** calls 'mutator(_T& data)' to change the guarded data in place -- readers will retry until it returns */
+        template <typename _Mutator>
+        inline void update(_Mutator&& mutator) {
+            uint32_t current = sequence.load(std::memory_order_relaxed);
+            // wait for other writers, if any
+            while ( (current & 1) || (!sequence.compare_exchange_weak(current, current+1, std::memory_order_acquire, std::memory_order_relaxed)) ) {
+                if constexpr (doCollectStandardMetrics) {
+                    SeqLockMetricsAdditionalFields::writeSpinsCount.fetch_add(1, std::memory_order_relaxed);
+                }
+                if (current & 1) {
+                	helperESpinMethod<_spinMethod>(sequence, current);
+                }
+                current = sequence.load(std::memory_order_relaxed);
+            }
+            helperESpinMethodWaitEnded<_spinMethod>();
+            // the odd sequence must be visible before any changes to the data
+            std::atomic_thread_fence(std::memory_order_release);
+            mutator(data);
+            if constexpr (doCollectStandardMetrics) {
+                // only the writer holding the sequence gets here: no RMW needed
+                SeqLockMetricsAdditionalFields::writesCount.store(SeqLockMetricsAdditionalFields::writesCount.load(std::memory_order_relaxed)+1, std::memory_order_relaxed);
+            }
+            sequence.store(current+2, std::memory_order_release);
+        }
+
+    };
+}
+
+#endif /* MTL_THREAD_SeqLock_hpp_ */
@@ -0,0 +1,236 @@
+/*! \file SharedSpinLock.hpp
+    \brief A drop-in for `std::shared_mutex`, with the same steroid options offered by `SpinLock`.
+
+    Readers never bounce a shared cache line: each one registers on a per-CPU reader slot.
+*/
+
+#ifndef MTL_THREAD_SharedSpinLock_hpp_
+#define MTL_THREAD_SharedSpinLock_hpp_
+
+#include <atomic>
+#include <sched.h>
+
+#include "SpinLock.hpp"
+
+
+namespace MTL::thread {
+
+    /** a reader counter, on its own cache line */
+    struct alignas(64) SharedSpinLockReaderSlot {
+        std::atomic<int32_t> readers = ATOMIC_VAR_INIT(0);
+    };
+
+    /** returns the reader slot (out of '_nReaderSlots') to be used by this thread on any `SharedSpinLock` -- picked once per
+      * thread, from the CPU it was running on at the time, so pinned threads never share their slot with other CPUs */
+    template <unsigned _nReaderSlots>
+    inline unsigned sharedSpinLockReaderSlotIndex() {
+        static std::atomic_uint fallbackSlotIndex = ATOMIC_VAR_INIT(0);
+        static thread_local unsigned slotIndex = [] {
+            int cpu = sched_getcpu();
+            return (cpu >= 0 ? (unsigned)cpu : fallbackSlotIndex.fetch_add(1, std::memory_order_relaxed)) % _nReaderSlots;
+        }();
+        return slotIndex;
+    }
+
+    /**
+     * SharedSpinLock.hpp
+     * ==================
+     *
+     * Reader-writer lock in the "big-reader lock" fashion: readers increment the counter on their own reader slot and
+     * only read (never write) the shared "writer active" flag, so read acquisitions scale with the number of cores.
+     * Writers are serialized by a regular `SpinLock` -- from which all options for metrics, debugging & hard lock
+     * fallback come -- then they raise the "writer active" flag and wait for all reader slots to drain.
+     * Writers have preference: readers arriving while a writer is active wait for the flag to be lowered. With a hard lock
+     * fallback, both the writer's wait for readers to drain and the readers' wait for the writer sleep on a futex after
+     * '_hardLockFallbackAfterCycles' -- and '_debugAfterCycles' reports writers waiting too long for readers.
+     *
+     * Implements both `Lockable` and `SharedLockable`, so it may replace `std::shared_mutex` in `std::shared_lock` & friends.
+     *
+    */
+    template<
+             /** see @ref SpinLock */
+             ESpinMethod          _spinMethod                  = ESpinMethod::CPURelax,
+             /** the writers' lock strategy -- see @ref SpinLock */
+             ELockSpecializations _lockStrategy                = ELockSpecializations::Mutex,
+             /** writers' lock metrics -- see @ref SpinLock */
+             bool                 _opMetrics                   = false,
+             /** see @ref SpinLock */
+             uint64_t             _debugAfterCycles            = !(uint64_t)0,
+             /** see @ref SpinLock */
+             const char*          _debugName                   = nullptr,
+             /** see @ref SpinLock */
+             uint64_t             _hardLockFallbackAfterCycles = !(uint64_t)0,
+             /** how many cache-line-padded reader counters to keep -- ideally, no less than the number of CPUs */
+             unsigned             _nReaderSlots                = 64>
+    class SharedSpinLock {
+
+        /** with a hard lock fallback, how long writers spin waiting for readers to drain -- and readers spin waiting for the
+          * writer to leave -- before sleeping on the futex. The adaptive & preemption aware sentinels use the adaptive ceiling */
+        static constexpr bool     doPark          = isHardLockFallbackEnabled<_hardLockFallbackAfterCycles>();
+        static constexpr uint64_t parkAfterCycles = isAdaptiveHardLockFallbackEnabled<_hardLockFallbackAfterCycles>() ?
+                                                        SpinLockAdaptiveFallbackAdditionalFields::maxSpinCycles : _hardLockFallbackAfterCycles;
+        static constexpr bool     doDebugSpinTimeouts = isSpinLockDebugEnabled<_debugAfterCycles>();
+
+        SpinLock<_spinMethod, _lockStrategy, _opMetrics, _debugAfterCycles, _debugName, _hardLockFallbackAfterCycles> writersLock;
+        alignas(64) std::atomic<int32_t>     writerActive   = ATOMIC_VAR_INIT(0);     // 1 while a writer holds (or drains) the lock -- also the readers' futex
+        std::atomic<int32_t>                 parkedReaders  = ATOMIC_VAR_INIT(0);     // readers sleeping on 'writerActive'
+        std::atomic<int32_t>                 writerParked   = ATOMIC_VAR_INIT(0);     // 1 while the writer sleeps on a reader slot
+        SharedSpinLockReaderSlot             readerSlots[_nReaderSlots];
+
+        /** must be 'seq_cst' to complete the Dekker handshake with 'lock_shared()': our 'writerActive' store and these loads
+          * may not be reordered, as their 'fetch_add' & 'writerActive' load may not be -- free on x86 & ARMv8 */
+        inline int _busy_reader_slot() {
+            for (unsigned i=0; i<_nReaderSlots; i++) {
+                if (readerSlots[i].readers.load(std::memory_order_seq_cst) != 0) {
+                    return i;
+                }
+            }
+            return -1;
+        }
+
+        inline bool _has_readers() {
+            return _busy_reader_slot() >= 0;
+        }
+
+        /** waits for all reader slots to drain -- spinning, then (with a hard lock fallback) sleeping on the busy slots */
+        inline void _drain_readers() {
+            uint64_t waitingStart = (doPark || doDebugSpinTimeouts) ? getProcessorCycleCount() : 0;
+            bool     debugged     = false;
+            int      busySlot;
+            while ((busySlot = _busy_reader_slot()) >= 0) {
+                std::atomic<int32_t>& readers = readerSlots[busySlot].readers;
+                int32_t current = readers.load(std::memory_order_relaxed);
+                if (current == 0) {
+                    continue;
+                }
+                if constexpr (doPark || doDebugSpinTimeouts) {
+                    uint64_t elapsedCycles = getProcessorCycleCount() - waitingStart;
+                    if constexpr (doDebugSpinTimeouts) {
+                        if ( (elapsedCycles > _debugAfterCycles) && (!debugged) ) {
+                            writersLock.issueDebugMessage("Waiting too long for readers to leave");
+                            debugged = true;
+                        }
+                    }
+                    if constexpr (doPark) {
+                        if (elapsedCycles > parkAfterCycles) {
+                            // 'unlock_shared()' wakes us if it sees 'writerParked' after its decrement -- otherwise, the futex
+                            // sees the decremented value and doesn't let us sleep
+                            writerParked.store(1, std::memory_order_seq_cst);
+                            FutexAdapter::wait(readers, current);
+                            writerParked.store(0, std::memory_order_relaxed);
+                            continue;
+                        }
+                    }
+                }
+                // waits on the reader slot, so 'WaitOnAddress' wakes up as soon as it is written
+                helperESpinMethod<_spinMethod>(readers, current);
+            }
+            helperESpinMethodWaitEnded<_spinMethod>();
+            if constexpr (doDebugSpinTimeouts) {
+                if (debugged) {
+                    writersLock.issueDebugMessage("Readers finally left");
+                }
+            }
+        }
+
+        /** lowers 'writerActive', waking readers sleeping on it */
+        inline void _release_writer() {
+            writerActive.store(0, std::memory_order_seq_cst);
+            if (parkedReaders.load(std::memory_order_seq_cst) > 0) {
+                FutexAdapter::wake(writerActive, INT_MAX);
+            }
+        }
+
+        /** leaves the reader slot, waking a writer sleeping on it */
+        inline void _leave_reader_slot(std::atomic<int32_t>& readers) {
+            readers.fetch_sub(1, std::memory_order_seq_cst);
+            if constexpr (doPark) {
+                if (writerParked.load(std::memory_order_seq_cst)) {
+                    FutexAdapter::wake(readers, 1);
+                }
+            }
+        }
+
+        /** waits for the writer to leave -- on 'writerActive', not on the writers' lock, so readers don't count as writers on
+          * its metrics, histograms & lock order validation. Spins, then (with a hard lock fallback) sleeps on it */
+        inline void _wait_for_writer() {
+            uint64_t waitingStart = doPark ? getProcessorCycleCount() : 0;
+            while (writerActive.load(std::memory_order_acquire)) {
+                if constexpr (doPark) {
+                    if ((getProcessorCycleCount() - waitingStart) > parkAfterCycles) {
+                        // '_release_writer()' wakes us if it sees us counted -- otherwise, we see 'writerActive' lowered
+                        parkedReaders.fetch_add(1, std::memory_order_seq_cst);
+                        while (writerActive.load(std::memory_order_seq_cst)) {
+                            FutexAdapter::wait(writerActive, 1);
+                        }
+                        parkedReaders.fetch_sub(1, std::memory_order_relaxed);
+                        break;
+                    }
+                }
+                helperESpinMethod<_spinMethod>(writerActive, 1);
+            }
+            helperESpinMethodWaitEnded<_spinMethod>();
+        }
+
+    public:
+
+        inline void issueDebugMessage(string message) {
+            writersLock.issueDebugMessage(message);
+        }
+
+        inline void lock() {
+            writersLock.lock();
+            // the store below must be visible before we read the reader slots (and readers do the opposite), hence 'seq_cst'
+            writerActive.store(1, std::memory_order_seq_cst);
+            _drain_readers();
+        }
+
+        inline bool try_lock() {
+            if (!writersLock.try_lock()) {
+                return false;
+            }
+            writerActive.store(1, std::memory_order_seq_cst);
+            if (_has_readers()) {
+                _release_writer();
+                writersLock.unlock();
+                return false;
+            }
+            return true;
+        }
+
+        inline void unlock() {
+            _release_writer();
+            writersLock.unlock();
+        }
+
+        inline void lock_shared() {
+            std::atomic<int32_t>& readers = readerSlots[sharedSpinLockReaderSlotIndex<_nReaderSlots>()].readers;
+            while (true) {
+                readers.fetch_add(1, std::memory_order_seq_cst);
+                if (!writerActive.load(std::memory_order_seq_cst)) {
+                    return;
+                }
+                // a writer is in: back off and wait for it
+                _leave_reader_slot(readers);
+                _wait_for_writer();
+            }
+        }
+
+        inline bool try_lock_shared() {
+            std::atomic<int32_t>& readers = readerSlots[sharedSpinLockReaderSlotIndex<_nReaderSlots>()].readers;
+            readers.fetch_add(1, std::memory_order_seq_cst);
+            if (!writerActive.load(std::memory_order_seq_cst)) {
+                return true;
+            }
+            _leave_reader_slot(readers);
+            return false;
+        }
+
+        inline void unlock_shared() {
+            _leave_reader_slot(readerSlots[sharedSpinLockReaderSlotIndex<_nReaderSlots>()].readers);
+        }
+
+    };
+}
+
+#endif /* MTL_THREAD_SharedSpinLock_hpp_ */
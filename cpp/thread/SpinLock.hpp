@@ -11,11 +11,25 @@
 #include <iostream>
 #include <string>
 #include <mutex>
+#include <algorithm>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <sstream>
+#include <thread>
+#include <memory>
+#include <ctime>
+#include <chrono>
+#include <pthread.h>
+#include <sched.h>
 //#include <boost/fiber/detail/cpu_relax.hpp>     // provides cpu_relax() macro, which uses the x86's "pause" or arm's "yield" instructions -- this has been commented out because boost fiber is not present on CentOS 7
 //#include <xmmintrin.h>                        // provides _mm_pause(). This would be an alternative to boost dependency, but it only works on x86, as of aug, 2019 -- and doesn't provide _mm_yield() as well...
 using namespace std;
 
 #include "cpu_relax.h"			// provides 'cpu_relax()'
+#include "rtm.h"                // provides 'isRTMAvailable()' & 'rtm_*()'
+#include "NumaTopology.hpp"
+#include "ThreadSlotIndex.hpp"
 #include "FutexAdapter.hpp"
 
 #include "../time/TimeMeasurements.hpp"
@@ -26,6 +40,13 @@ using namespace MTL::time::TimeMeasurements;
 #define likely(x)       __builtin_expect((x),1)
 #define unlikely(x)     __builtin_expect((x),0)
 
+// 'pthread_mutex_clocklock()', used for the timed 'hard_lock' of the 'Mutex' strategy, is available since glibc 2.30
+#if defined(__GLIBC__) && ( (__GLIBC__ > 2) || ( (__GLIBC__ == 2) && (__GLIBC_MINOR__ >= 30) ) )
+    #define MTL_THREAD_PTHREAD_CLOCKLOCK 1
+#else
+    #define MTL_THREAD_PTHREAD_CLOCKLOCK 0
+#endif
+
 namespace MTL::thread {
 
     /** conditional base class when using a spin lock with metrics DISABLED */
@@ -60,6 +81,81 @@ namespace MTL::thread {
         }
     };
 
+    /** how many per-thread shards each `SpinLock` with sharded metrics keeps -- one per @ref ThreadSlotIndex */
+    constexpr unsigned SpinLockMetricsShards = ThreadSlots;
+
+    /** the metrics of a `SpinLock`, as seen by a thread -- see @ref SpinLockShardedMetricsAdditionalFields */
+    struct alignas(64) SpinLockMetricsShard {
+        std::atomic<uint64_t> lockCallsCount, unlockCallsCount, tryLocksCount, hardLocksCount;
+        std::atomic<uint64_t> cpuCyclesLocked, cpuCyclesWaitingToLock;
+    };
+
+    /** the metrics of a `SpinLock`, aggregated from all its shards */
+    struct SpinLockMetricsSnapshot {
+        uint64_t lockCallsCount, unlockCallsCount, tryLocksCount, hardLocksCount;
+        uint64_t cpuCyclesLocked, cpuCyclesWaitingToLock;
+    };
+
+    /** conditional base class when using a spin lock with sharded metrics DISABLED */
+    struct SpinLockShardedMetricsNoAdditionalFields {};
+    /** conditional base class when using a spin lock with sharded metrics ENABLED: the same metrics as @ref SpinLockStandardMetricsAdditionalFields
+      * (plus 'hardLocksCount'), but each thread counts on its own cache-line-padded shard and they are summed up on read --
+      * so counts are exact, even for those made before the lock is acquired, without adding a shared RMW to the hot path */
+    struct SpinLockShardedMetricsAdditionalFields {
+        SpinLockMetricsShard              shards[SpinLockMetricsShards];
+        alignas(64) std::atomic<uint64_t> lockStart;     // only written by the lock holder
+
+        inline void reset() {
+            for (SpinLockMetricsShard& shard : shards) {
+                for (std::atomic<uint64_t>* counter : {&shard.lockCallsCount, &shard.unlockCallsCount, &shard.tryLocksCount,
+                                                       &shard.hardLocksCount, &shard.cpuCyclesLocked,  &shard.cpuCyclesWaitingToLock}) {
+                    counter->store(0, std::memory_order_relaxed);
+                }
+            }
+            lockStart.store(!(uint64_t)0, std::memory_order_relaxed); // special value (to debug messages) denoting we are unlocked
+        }
+
+        /** adds 'value' to the 'counter' on the current thread's shard */
+        inline void count(std::atomic<uint64_t> SpinLockMetricsShard::* counter, uint64_t value = 1) {
+            const ThreadSlotIndex&           shardIndex   = threadSlotIndex;
+            std::atomic<uint64_t>&           shardCounter = shards[shardIndex.index].*counter;
+            if (likely (shardIndex.exclusive) ) {
+                shardCounter.store(shardCounter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+            } else {
+                shardCounter.fetch_add(value, std::memory_order_relaxed);
+            }
+        }
+
+        inline SpinLockMetricsSnapshot aggregate() const {
+            SpinLockMetricsSnapshot snapshot = {};
+            for (const SpinLockMetricsShard& shard : shards) {
+                snapshot.lockCallsCount         += shard.lockCallsCount.load(std::memory_order_relaxed);
+                snapshot.unlockCallsCount       += shard.unlockCallsCount.load(std::memory_order_relaxed);
+                snapshot.tryLocksCount          += shard.tryLocksCount.load(std::memory_order_relaxed);
+                snapshot.hardLocksCount         += shard.hardLocksCount.load(std::memory_order_relaxed);
+                snapshot.cpuCyclesLocked        += shard.cpuCyclesLocked.load(std::memory_order_relaxed);
+                snapshot.cpuCyclesWaitingToLock += shard.cpuCyclesWaitingToLock.load(std::memory_order_relaxed);
+            }
+            return snapshot;
+        }
+
+        inline void debugMetrics(stringstream& c, bool withHardLocks) {
+            SpinLockMetricsSnapshot snapshot = aggregate();
+            c << "lockCallsCount="          << snapshot.lockCallsCount         << ", "
+                 "unlockCallsCount="        << snapshot.unlockCallsCount       << ", "
+                 "tryLocksCount="           << snapshot.tryLocksCount          << ", "
+                 "cpuCyclesLocked="         << snapshot.cpuCyclesLocked        << ", "
+                 "cpuCyclesWaitingToLock="  << snapshot.cpuCyclesWaitingToLock;
+            uint64_t lastLockStart = lockStart.load(std::memory_order_relaxed);
+            if (lastLockStart != !(uint64_t)0) {
+                c << ", lastLockElapseCycles="  << (getProcessorCycleCount()-lastLockStart);
+            }
+            if (withHardLocks) {
+                c << ", hardLocksCount="        << snapshot.hardLocksCount;
+            }
+        }
+    };
+
     /** conditional base class when having metrics enabled and hard_lock fallback DISABLED */
     struct SpinLockHardLockMetricsNoAdditionalFields {};
     /** conditional base class when having metrics enabled and hard_lock fallback also ENABLED */
@@ -74,6 +170,394 @@ namespace MTL::thread {
         }
     };
 
+    /** special value for the `SpinLock`'s '_hardLockFallbackAfterCycles' template parameter: instead of a fixed number of cycles,
+      * the spin budget is learnt at runtime, per lock instance -- see @ref SpinLockAdaptiveFallbackAdditionalFields */
+    constexpr uint64_t SpinLockAdaptiveHardLockFallback = ~(uint64_t)0;
+
+    /** conditional base class when the hard_lock fallback is DISABLED or uses a fixed number of cycles */
+    struct SpinLockAdaptiveFallbackNoAdditionalFields {};
+    /** conditional base class when the hard_lock fallback is ADAPTIVE: like glibc's adaptive mutexes, keeps a moving average
+      * of the cycles contended acquisitions needed to get the lock by spinning -- those that had to fall back to 'hard_lock'ing
+      * count as zero -- and spins up to twice that before falling back. Locks usually released shortly keep on spinning while
+      * the ones held for long park almost right away, following the hold times as they drift */
+    struct SpinLockAdaptiveFallbackAdditionalFields {
+        static constexpr uint64_t minSpinCycles = 1'000;
+        static constexpr uint64_t maxSpinCycles = 10'000'000;
+        std::atomic<uint64_t> averageSpinCycles;     // only written by the lock holder
+
+        inline void reset() {
+            averageSpinCycles.store(minSpinCycles, std::memory_order_relaxed);
+        }
+
+        inline uint64_t spinBudget() {
+            return std::min(maxSpinCycles, 2*averageSpinCycles.load(std::memory_order_relaxed) + minSpinCycles);
+        }
+
+        /** to be called, while holding the lock, after a contended acquisition */
+        inline void learn(uint64_t spinCycles) {
+            uint64_t average = averageSpinCycles.load(std::memory_order_relaxed);
+            // newer samples weight 1/8
+            averageSpinCycles.store(average - (average/8) + (std::min(spinCycles, maxSpinCycles)/8), std::memory_order_relaxed);
+        }
+
+        inline void debugAdaptiveFallbackMetrics(stringstream& c) {
+            c << ", adaptiveSpinBudget="      << spinBudget();
+        }
+    };
+
+    /** special value for the `SpinLock`'s '_hardLockFallbackAfterCycles' template parameter: like @ref SpinLockAdaptiveHardLockFallback,
+      * but waiters also fall back to 'hard_lock'ing as soon as they find the lock holder is not running -- see
+      * @ref SpinLockPreemptionAwareAdditionalFields. Pair it with a lock strategy whose 'hard_lock' parks the thread (`Futex` or `Mutex`) */
+    constexpr uint64_t SpinLockPreemptionAwareHardLockFallback = ~(uint64_t)1;
+
+    /** conditional base class when the hard_lock fallback is NOT preemption aware */
+    struct SpinLockPreemptionAwareNoAdditionalFields {};
+    /** conditional base class when the hard_lock fallback is PREEMPTION AWARE: the lock holder publishes the CPU it runs on and
+      * its thread's CPU-time clock. Every 'checkEveryCycles', waiters consider the holder preempted if they are running on its
+      * CPU -- a cheap check, as 'sched_getcpu()' is served from the 'rseq' area (or the vDSO). Less often, they also consider
+      * it preempted (or blocked) if its CPU time didn't advance since their previous probe: reading another thread's CPU-time
+      * clock is a real syscall (~1us), which takes the holder's runqueue lock -- so, while the holder is seen progressing,
+      * each waiter doubles its probing interval, from 'checkEveryCycles' up to 'maxProbeEveryCycles', restarting from the
+      * former whenever the lock changes hands */
+    struct alignas(64) SpinLockPreemptionAwareAdditionalFields {
+        static constexpr uint64_t  checkEveryCycles    = 20'000;
+        static constexpr uint64_t  maxProbeEveryCycles = 64 * checkEveryCycles;
+        static constexpr clockid_t NO_OWNER            = (clockid_t)-1;
+
+        /** the CPU-time clock of the current thread, suitable for other threads to query */
+        static inline thread_local clockid_t threadCPUTimeClock = [] {
+            clockid_t clock;
+            return pthread_getcpuclockid(pthread_self(), &clock) == 0 ? clock : NO_OWNER;
+        }();
+
+        /** waiter's view of the lock holder, kept across its spin checks */
+        struct OwnerWatch {
+            uint64_t  nextCheck;
+            uint64_t  nextProbe  = 0;
+            uint64_t  probeEvery = checkEveryCycles;
+            clockid_t clock      = NO_OWNER;
+            uint64_t  cpuTimeNs  = 0;
+        };
+
+        std::atomic<int>       ownerCPU;
+        std::atomic<clockid_t> ownerCPUTimeClock;
+
+        inline void reset() {
+            ownerCPU.store(-1, std::memory_order_relaxed);
+            ownerCPUTimeClock.store(NO_OWNER, std::memory_order_relaxed);
+        }
+
+        /** to be called right after acquiring the lock -- 'sched_getcpu()' is served from the 'rseq' area on recent glibcs */
+        inline void publishOwner() {
+            ownerCPU.store(sched_getcpu(), std::memory_order_relaxed);
+            ownerCPUTimeClock.store(threadCPUTimeClock, std::memory_order_relaxed);
+        }
+
+        /** to be called right before releasing the lock */
+        inline void unpublishOwner() {
+            ownerCPUTimeClock.store(NO_OWNER, std::memory_order_relaxed);
+        }
+
+        /** to be called by waiters, while spinning, with the current cycle count */
+        inline bool isOwnerPreempted(OwnerWatch& watch, uint64_t now) {
+            if (now < watch.nextCheck) {
+                return false;
+            }
+            watch.nextCheck = now + checkEveryCycles;
+            clockid_t clock = ownerCPUTimeClock.load(std::memory_order_relaxed);
+            if (clock == NO_OWNER) {
+                return false;
+            }
+            int cpu = ownerCPU.load(std::memory_order_relaxed);
+            if ( (cpu >= 0) && (cpu == sched_getcpu()) ) {
+                return true;    // we are the ones running on the holder's CPU
+            }
+            bool sameOwner = (clock == watch.clock);
+            if ( sameOwner && (now < watch.nextProbe) ) {
+                return false;
+            }
+            struct timespec cpuTime;
+            if (clock_gettime(clock, &cpuTime) != 0) {
+                return true;    // the holder thread is gone
+            }
+            uint64_t cpuTimeNs = (uint64_t)cpuTime.tv_sec*1'000'000'000 + (uint64_t)cpuTime.tv_nsec;
+            bool     stalled   = sameOwner && (cpuTimeNs == watch.cpuTimeNs);
+            watch.probeEvery = sameOwner ? std::min(watch.probeEvery*2, maxProbeEveryCycles) : checkEveryCycles;
+            watch.nextProbe  = now + watch.probeEvery;
+            watch.clock      = clock;
+            watch.cpuTimeNs  = cpuTimeNs;
+            return stalled;
+        }
+    };
+
+    /** log2-bucketed histogram of cycle counts: bucket 'b' counts the values in [2^(b-1), 2^b) -- bucket 0 counting zeroes.
+      * Meant to be recorded only by the lock holder, so increments are plain loads & stores (no RMW), while the relaxed
+      * atomics allow 'snapshot()' to be taken from any thread, at any time, without stopping the world */
+    struct SpinLockLog2Histogram {
+        static constexpr unsigned nBuckets = 65;
+        std::atomic<uint64_t> buckets[nBuckets];
+
+        /** percentiles are given as the (exclusive) upper bound of the bucket they fall in -- a power of 2 */
+        struct Snapshot {
+            uint64_t count, p50, p99, p999;
+        };
+
+        inline void reset() {
+            for (unsigned i=0; i<nBuckets; i++) {
+                buckets[i].store(0, std::memory_order_relaxed);
+            }
+        }
+
+        inline void record(uint64_t cycles) {
+            unsigned bucket = cycles == 0 ? 0 : 64 - __builtin_clzll(cycles);
+            buckets[bucket].store(buckets[bucket].load(std::memory_order_relaxed)+1, std::memory_order_relaxed);
+        }
+
+        inline Snapshot snapshot() const {
+            uint64_t counts[nBuckets];
+            uint64_t count = 0;
+            for (unsigned i=0; i<nBuckets; i++) {
+                counts[i] = buckets[i].load(std::memory_order_relaxed);
+                count    += counts[i];
+            }
+            auto percentile = [&counts, count](uint64_t perMille) -> uint64_t {
+                uint64_t rank       = std::max<uint64_t>(1, (count*perMille + 999) / 1000);
+                uint64_t cumulative = 0;
+                for (unsigned i=0; i<nBuckets; i++) {
+                    cumulative += counts[i];
+                    if (cumulative >= rank) {
+                        return i == 64 ? ~(uint64_t)0 : (uint64_t)1 << i;
+                    }
+                }
+                return 0;   // empty histogram
+            };
+            return {count, percentile(500), percentile(990), percentile(999)};
+        }
+    };
+
+    /** snapshot of a `SpinLock`'s histograms, as returned by 'SpinLock::histogramsSnapshot()' */
+    struct SpinLockHistogramsSnapshot {
+        SpinLockLog2Histogram::Snapshot waitCycles, holdCycles;
+    };
+
+    /** conditional base class when using a spin lock with histograms DISABLED */
+    struct SpinLockHistogramsNoAdditionalFields {};
+    /** conditional base class when using a spin lock with histograms ENABLED */
+    struct alignas(64) SpinLockHistogramsAdditionalFields {
+        SpinLockLog2Histogram waitCyclesHistogram;
+        SpinLockLog2Histogram holdCyclesHistogram;
+        uint64_t              histogramLockStart;
+
+        inline void reset() {
+            waitCyclesHistogram.reset();
+            holdCyclesHistogram.reset();
+            histogramLockStart = !(uint64_t)0;     // special value denoting we are unlocked
+        }
+
+        inline void debugHistograms(stringstream& c) {
+            auto print = [&c](const char* name, const SpinLockLog2Histogram::Snapshot& snapshot) {
+                c << ", " << name << "={p50<" << snapshot.p50 << ", p99<" << snapshot.p99 << ", p999<" << snapshot.p999 << "}";
+            };
+            print("waitCycles", waitCyclesHistogram.snapshot());
+            print("holdCycles", holdCyclesHistogram.snapshot());
+        }
+    };
+
+    /** the lock order validator is part of the debug machinery (see `SpinLock`'s '_debugAfterCycles') on all but release builds */
+#ifdef NDEBUG
+    constexpr bool SpinLockLockOrderValidation = false;
+#else
+    constexpr bool SpinLockLockOrderValidation = true;
+#endif
+
+    /** lockdep-like validator: keeps, per thread, the stack of held locks and, globally, the graph of "acquired while holding"
+      * edges between lock classes -- the '_debugName' of a `SpinLock` or, for unnamed ones, the instance itself.
+      * Whenever a new edge closes a cycle, the potential deadlock is reported to 'stderr', once, before waiting for the lock.
+      * Each acquisition gets a unique id: locks released by other threads (semaphore style) publish the id of the acquisition
+      * they ended, so the acquiring thread drops it from its stack -- or, if it already exited, the id is purged. No pointers
+      * to the locks are kept, so they may be destroyed at any time. Unnamed locks have their edges purged on destruction, so
+      * new locks at the same address start fresh */
+    struct SpinLockLockOrderValidator {
+
+        struct HeldLock {
+            const void* lockClass;
+            uint64_t    acquisitionId;
+        };
+
+        struct Graph {
+            std::mutex                                                      mutex;
+            std::unordered_map<const void*, std::vector<const void*>>       edges;      // lockClass --> classes acquired while holding it
+            std::unordered_map<const void*, string>                         names;
+            std::unordered_map<const void*, std::unordered_set<const void*>> reportedPairs;    // lockClass --> held classes whose inversions were reported
+            std::unordered_set<uint64_t>                                    releasedByOthers; // ids of acquisitions released by a thread other than the acquirer
+            std::unordered_set<uint64_t>                                    heldByExited;     // ids of acquisitions whose threads exited before they got released
+        };
+
+        static Graph& graph() {
+            static Graph lockOrderGraph;
+            return lockOrderGraph;
+        }
+
+        static inline std::atomic<size_t>   nReleasedByOthers = ATOMIC_VAR_INIT(0);    // 'Graph::releasedByOthers.size()'
+
+        /** the locks held by a thread -- which, on exit, forgets those released by others it didn't prune yet, and lets
+          * 'released()' know about the ones still held, so neither stays on 'Graph::releasedByOthers' forever */
+        struct HeldLocks: std::vector<HeldLock> {
+            ~HeldLocks() {
+                if (empty()) {
+                    return;
+                }
+                Graph& g = graph();
+                std::lock_guard<std::mutex> guard(g.mutex);
+                for (const HeldLock& held : *this) {
+                    if (g.releasedByOthers.erase(held.acquisitionId) == 0) {
+                        g.heldByExited.insert(held.acquisitionId);
+                    }
+                }
+                nReleasedByOthers.store(g.releasedByOthers.size(), std::memory_order_relaxed);
+            }
+        };
+
+        static inline thread_local HeldLocks              heldLocks;
+        static inline std::atomic<uint64_t>               lastAcquisitionId = ATOMIC_VAR_INIT(0);
+
+        static string className(const char* debugName, const void* instance) {
+            stringstream c;
+            if (debugName != nullptr) {
+                c << "'" << debugName << "'";
+            } else {
+                c << "SpinLock@" << instance;
+            }
+            return c.str();
+        }
+
+        /** drops the locks released by other threads */
+        static void pruneReleased() {
+            if ( heldLocks.empty() || (nReleasedByOthers.load(std::memory_order_relaxed) == 0) ) {
+                return;
+            }
+            Graph& g = graph();
+            std::lock_guard<std::mutex> guard(g.mutex);
+            heldLocks.erase(std::remove_if(heldLocks.begin(), heldLocks.end(), [&g](const HeldLock& held) {
+                return g.releasedByOthers.erase(held.acquisitionId) > 0;
+            }), heldLocks.end());
+            nReleasedByOthers.store(g.releasedByOthers.size(), std::memory_order_relaxed);
+        }
+
+        /** depth first search for a path 'from' --> ... --> 'to', returned in 'path' */
+        static bool findPath(Graph& g, const void* from, const void* to, std::vector<const void*>& path, std::unordered_set<const void*>& visited) {
+            path.push_back(from);
+            if (from == to) {
+                return true;
+            }
+            if (visited.insert(from).second) {
+                auto edges = g.edges.find(from);
+                if (edges != g.edges.end()) {
+                    for (const void* next : edges->second) {
+                        if (findPath(g, next, to, path, visited)) {
+                            return true;
+                        }
+                    }
+                }
+            }
+            path.pop_back();
+            return false;
+        }
+
+        /** to be called before waiting to acquire a lock of 'lockClass' */
+        static void beforeLock(const void* lockClass, const char* debugName, const void* instance) {
+            pruneReleased();
+            if (heldLocks.empty()) {
+                return;
+            }
+            Graph& g = graph();
+            std::lock_guard<std::mutex> guard(g.mutex);
+            g.names.try_emplace(lockClass, className(debugName, instance));
+            for (const HeldLock& held : heldLocks) {
+                if (held.lockClass == lockClass) {
+                    continue;
+                }
+                std::vector<const void*>& heldEdges = g.edges[held.lockClass];
+                if (std::find(heldEdges.begin(), heldEdges.end(), lockClass) != heldEdges.end()) {
+                    continue;   // order already known & validated
+                }
+                std::vector<const void*>        path;
+                std::unordered_set<const void*> visited;
+                if (findPath(g, lockClass, held.lockClass, path, visited) && g.reportedPairs[lockClass].insert(held.lockClass).second) {
+                    stringstream c;
+                    c << "MTL::SpinLock lock order validator: possible deadlock -- thread " << std::this_thread::get_id()
+                      << " acquires " << g.names[lockClass] << " while holding " << g.names[held.lockClass]
+                      << ", but the opposite order was already seen: ";
+                    for (size_t i=0; i<path.size(); i++) {
+                        c << (i > 0 ? " --> " : "") << g.names[path[i]];
+                    }
+                    c << "\n";
+                    std::cerr << c.str() << std::flush;
+                }
+                heldEdges.push_back(lockClass);
+            }
+        }
+
+        /** to be called after acquiring a lock (either by 'lock()' or 'try_lock()') */
+        static void acquired(const void* lockClass, const char* debugName, const void* instance, std::atomic<uint64_t>& acquisitionId) {
+            if (heldLocks.empty() || heldLocks.back().lockClass != lockClass) {
+                Graph& g = graph();
+                std::lock_guard<std::mutex> guard(g.mutex);
+                g.names.try_emplace(lockClass, className(debugName, instance));
+            }
+            uint64_t id = lastAcquisitionId.fetch_add(1, std::memory_order_relaxed) + 1;
+            acquisitionId.store(id, std::memory_order_relaxed);
+            heldLocks.push_back({lockClass, id});
+        }
+
+        /** to be called before releasing a lock -- from any thread */
+        static void released(const std::atomic<uint64_t>& acquisitionId) {
+            uint64_t id = acquisitionId.load(std::memory_order_relaxed);
+            for (auto held = heldLocks.rbegin(); held != heldLocks.rend(); ++held) {
+                if (held->acquisitionId == id) {
+                    heldLocks.erase(std::next(held).base());
+                    return;
+                }
+            }
+            if (id == 0) {
+                return;     // never acquired
+            }
+            // acquired by another thread: let it know, on its next 'pruneReleased()' -- unless it is gone
+            Graph& g = graph();
+            std::lock_guard<std::mutex> guard(g.mutex);
+            if (g.heldByExited.erase(id) == 0) {
+                g.releasedByOthers.insert(id);
+            }
+            nReleasedByOthers.store(g.releasedByOthers.size(), std::memory_order_relaxed);
+        }
+
+        /** to be called when a lock is destroyed: unnamed locks are their own class, which must not be inherited by
+          * another lock later created at the same address */
+        static void destroyed(const void* lockClass, const void* instance) {
+            if (lockClass != instance) {
+                return;     // named classes outlive their instances
+            }
+            Graph& g = graph();
+            std::lock_guard<std::mutex> guard(g.mutex);
+            g.edges.erase(lockClass);
+            for (auto& [heldClass, acquiredClasses] : g.edges) {
+                acquiredClasses.erase(std::remove(acquiredClasses.begin(), acquiredClasses.end(), lockClass), acquiredClasses.end());
+            }
+            g.reportedPairs.erase(lockClass);
+            for (auto& [acquiredClass, heldClasses] : g.reportedPairs) {
+                heldClasses.erase(lockClass);
+            }
+            g.names.erase(lockClass);
+        }
+    };
+
+    /** conditional base class when the lock order validator is DISABLED */
+    struct SpinLockLockOrderNoAdditionalFields {};
+    /** conditional base class when the lock order validator is ENABLED */
+    struct SpinLockLockOrderAdditionalFields {
+        std::atomic<uint64_t> acquisitionId = ATOMIC_VAR_INIT(0);     // of the current (or last) acquisition -- see 'SpinLockLockOrderValidator'
+    };
+
     /** signature type for our callbacks */
     typedef void(*SpinLockCallbackSignature)(size_t);
 
@@ -102,8 +586,28 @@ namespace MTL::thread {
         }
     }
 
+    /** constexpr to check if the hard_lock fallback should learn its spin budget at runtime */
+    template <uint64_t _hardLockFallbackAfterCycles>
+    inline constexpr bool isAdaptiveHardLockFallbackEnabled() {
+        return (_hardLockFallbackAfterCycles == SpinLockAdaptiveHardLockFallback) ||
+               (_hardLockFallbackAfterCycles == SpinLockPreemptionAwareHardLockFallback);
+    }
+
+    /** constexpr to check if the hard_lock fallback should also happen when the lock holder is not running */
+    template <uint64_t _hardLockFallbackAfterCycles>
+    inline constexpr bool isPreemptionAwareHardLockFallbackEnabled() {
+        return _hardLockFallbackAfterCycles == SpinLockPreemptionAwareHardLockFallback;
+    }
+
+    /** while spinning on `SpinLock::try_lock_until()`, the clock is only read (to check the deadline) after this many CPU cycles */
+    constexpr uint64_t SpinLockTimedLockClockCheckCycles = 2'000;
+
+    /** how long `RobustFutex` `SpinLock`s with no hard lock fallback spin before sleeping on the futex anyway -- as dead
+      * owners are only detected by sleeping waiters */
+    constexpr uint64_t SpinLockRobustFutexSpinCycles = 10'000'000;
+
     /** Specifies the spin method while we wait to get a lock -- 'CPURelax' tends to bring better latency on very low contended guards */
-    enum ESpinMethod {
+    enum ESpinMethod : uint64_t {
         /** By using this, the spin algorithm continually tests the lock. It might have the best latency if you have less
           * than one of these per core. Some call any form of spinning a "busy wait". Think of this as a "really busy
           * wait" when compared to the other options. */
@@ -120,7 +624,61 @@ namespace MTL::thread {
           * on highly contended locks and on CPUs that have a very slow cache synchronization, on which
           * constantly testing the lock has a higher cost than a context-switch. */
         Yield,
+        /** Truncated exponential backoff with jitter, made only of `cpu_relax()` bursts -- no syscalls: each consecutive spin
+          * of a thread doubles its limit (starting at a floor, up to a ceiling), and the burst size is a random number between
+          * half and the whole limit, so contenders get out of sync and far less RMWs fail on heavily contended locks.
+          * Defaults to a floor of 4 and a ceiling of 1024 `cpu_relax()`s -- use @ref exponentialBackoffSpinMethod() for others. */
+        ExponentialBackoff,
+        /** Sleeps the core on a low power state until the lock word is written -- see `cpu_wait_on_address()`: UMONITOR/UMWAIT on
+          * Intel CPUs having WAITPKG or WFE on ARMv8 -- waking up within tens of nanoseconds of the unlock, without taking execution
+          * resources from the sibling hyperthread. Lock strategies with no single word to watch (like `Mutex` & `AtomicFlag`) --
+          * and so nothing to be woken up by -- spin with `cpu_relax()`, as `CPURelax` does. Falls back to `CPURelax` on CPUs
+          * lacking these instructions. */
+        WaitOnAddress,
     };
+
+    /** Returns an 'ESpinMethod::ExponentialBackoff' with the given floor & ceiling (in number of `cpu_relax()`s),
+      * to be used wherever a '_spinMethod' template parameter is expected. Ex:
+      *     SpinLock<exponentialBackoffSpinMethod<8, 4096>(), ELockSpecializations::RMWLight> */
+    template <uint16_t _floor, uint16_t _ceiling>
+    constexpr ESpinMethod exponentialBackoffSpinMethod() {
+        static_assert((_floor > 0) && (_floor <= _ceiling), "'exponentialBackoffSpinMethod' requires 0 < floor <= ceiling");
+        return ESpinMethod(ESpinMethod::ExponentialBackoff | ((uint64_t)_floor << 16) | ((uint64_t)_ceiling << 32));
+    }
+
+    /** Truncated exponential backoff with jitter state, kept per thread, so that `helperESpinMethod()` may continue to be
+      * called from the usual `while (!_try_lock())` loops. The limit goes back to the floor when a wait ends -- the lock
+      * acquired or the awaited word changed -- as told by `helperESpinMethodWaitEnded()` */
+    struct ExponentialBackoffState {
+        uint32_t limit = 0;     // 0: a new wait, starting at the floor
+        uint32_t seed  = 0;
+
+        template <uint32_t _floor, uint32_t _ceiling>
+        inline void spin() {
+            if (limit == 0) {
+                limit = _floor;
+            }
+            if (seed == 0) {
+                seed = ((uint32_t)getProcessorCycleCount()) | 1;
+            }
+            // xorshift32 jitter: spins for [limit/2, limit] `cpu_relax()`s
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            uint32_t spins = (limit/2) + (seed % ((limit/2)+1));
+            for (uint32_t i=0; i<spins; i++) {
+                cpu_relax();
+            }
+            limit = std::min(limit*2, _ceiling);
+        }
+
+        /** the next 'spin()' starts a new wait */
+        inline void reset() {
+            limit = 0;
+        }
+    };
+    inline thread_local ExponentialBackoffState exponentialBackoffState;
+
     /** Helper method to execute what is said in 'ESpinMethod' */
     template <ESpinMethod _spinMethod>
     inline void helperESpinMethod() {
@@ -138,11 +696,59 @@ namespace MTL::thread {
             //static struct timespec req = {0, 300};
             ////nanosleep(&req, (struct timespec *)NULL);
             //clock_nanosleep(CLOCK_MONOTONIC, 0, &req, nullptr);
+        } else if constexpr ((_spinMethod & 0xFFFF) == ESpinMethod::ExponentialBackoff) {
+            constexpr uint32_t backoffFloor   = (_spinMethod >> 16) & 0xFFFF;
+            constexpr uint32_t backoffCeiling = (_spinMethod >> 32) & 0xFFFF;
+            if constexpr (backoffFloor == 0) {
+                exponentialBackoffState.spin<4, 1024>();     // defaults
+            } else {
+                exponentialBackoffState.spin<backoffFloor, backoffCeiling>();
+            }
+        } else if constexpr (_spinMethod == ESpinMethod::WaitOnAddress) {
+            cpu_relax();    // no word to be woken up by: see the overload below
         } else {
             static_assert(_spinMethod == -1, "Unknown 'ESpinMethod'. Please update the selection code.");
         }
     }
 
+    /** The same as 'helperESpinMethod()', for spins waiting for 'word' to change from 'current' -- which allows
+      * 'ESpinMethod::WaitOnAddress' to sleep until it gets written */
+    template <ESpinMethod _spinMethod, typename _T>
+    inline void helperESpinMethod(const std::atomic<_T>& word, _T current) {
+        if constexpr (_spinMethod == ESpinMethod::WaitOnAddress) {
+            cpu_wait_on_address(word, current);
+        } else {
+            helperESpinMethod<_spinMethod>();
+        }
+    }
+
+    /** To be called when a wait spun with 'helperESpinMethod()' is over -- the lock acquired, the awaited word changed or
+      * the deadline reached -- so the next wait starts afresh: only 'ESpinMethod::ExponentialBackoff' keeps state across
+      * spins, and no code is generated for the others */
+    template <ESpinMethod _spinMethod>
+    inline void helperESpinMethodWaitEnded() {
+        if constexpr ((_spinMethod & 0xFFFF) == ESpinMethod::ExponentialBackoff) {
+            exponentialBackoffState.reset();
+        }
+    }
+
+    /** tells if a lock specialization has '_spin_wait()' -- a spin watching its lock word, as 'helperESpinMethod(word, current)' */
+    template <typename _LockSpecialization, typename = void>
+    struct HasSpinWait: std::false_type {};
+    template <typename _LockSpecialization>
+    struct HasSpinWait<_LockSpecialization, std::void_t<decltype(std::declval<_LockSpecialization&>()._spin_wait())>>: std::true_type {};
+
+    /** The same as 'helperESpinMethod()', for spins waiting for 'lockSpecialization' to be released -- watching its lock word,
+      * if it has one, so 'ESpinMethod::WaitOnAddress' may sleep until it gets written */
+    template <ESpinMethod _spinMethod, typename _LockSpecialization>
+    inline void helperESpinMethodOn(_LockSpecialization& lockSpecialization) {
+        if constexpr (HasSpinWait<_LockSpecialization>::value) {
+            lockSpecialization._spin_wait();
+        } else {
+            helperESpinMethod<_spinMethod>();
+        }
+    }
+
     /** Specifies what to do when there is no more reason to spin while we wait to get a lock. */
     enum class EHardLockMethod {
         /** Keep on spinning anyway -- use this if you have plenty of CPU left and want to trade it for low latency */
@@ -176,8 +782,82 @@ namespace MTL::thread {
 		/** This specialization splits the synchronization task between two different regions of memory (the "head" and the "tail"),
 		 *  obtaining speed gains on machines with a high number of CPUs (on which RMW operations can be really expensive). */
 		Ouroboros,
+        /** Ticket lock: like @ref Ouroboros, keeps the "next ticket" and "now serving" counters on different cache lines, but
+         *  each waiter takes its ticket with a single `fetch_add` and then only reads "now serving", backing off proportionally
+         *  to its distance to it -- so there is just one RMW per acquisition and the lock is granted in FIFO order. */
+        Ticket,
+        /** Mellor-Crummey & Scott queue lock: waiters enqueue themselves with a single RMW on the "tail" and then spin on a flag
+         *  living on their own cache line, which is set by their predecessor when it unlocks -- so the handoff latency stays flat
+         *  regardless of the number of contenders and the lock is granted in FIFO order. Note that the controlled spin done by
+         *  `SpinLock` (when metrics, debug or hard lock fallback are enabled) relies on `try_lock()`, which doesn't enqueue. */
+        MCS,
+        /** Craig, Landin & Hagersten queue lock: like @ref MCS, but each waiter spins on the node of its predecessor, which
+         *  makes `unlock()` a single store (no RMW) at the cost of nodes migrating among threads. */
+        CLH,
+        /** Lock elision: on CPUs having Intel's TSX/RTM (detected at runtime), the critical section runs inside a hardware
+         *  transaction which only reads the lock word -- so threads updating disjoint data run truly in parallel. On aborts
+         *  (conflicts, capacity, syscalls, ...) or on CPUs without RTM, falls back to @ref RMWLight.
+         *  Note that, when elided, the lock must be unlocked by the same thread that locked it -- and that `SpinLock`'s metrics,
+         *  histograms, adaptive & preemption aware fallbacks are refused at compile time, since they write to shared fields
+         *  when the lock is taken, which would happen inside the transaction, making concurrent holders abort each other.
+         *  The lock order validator of debug builds does the same, so expect no elision there. */
+        Elided,
+        /** The same as @ref Elided, but falling back to @ref Futex */
+        ElidedFutex,
+        /** NUMA aware cohort lock: a @ref RMWLight lock per NUMA node (detected from `/sys/devices/system/node`) plus a global one.
+         *  Waiters first take their node's lock, then the global one -- unless it was handed over by the previous holder of their
+         *  node's lock, which keeps the global lock for up to 'maxLocalHandoffs' consecutive same node waiters -- so the lock and
+         *  the data it guards stay on a socket for longer. Like @ref MCS, only `lock()` (and not `try_lock()`) counts as waiting --
+         *  so, when `SpinLock` does its controlled spin (metrics, debug or hard lock fallbacks enabled), a contended `lock()`
+         *  goes straight to the waiter counting spin, with no spin debug messages nor hard lock fallbacks. */
+        Cohort,
+        /** The same as @ref Cohort, but using @ref Ouroboros locks */
+        CohortOuroboros,
+        /** Priority inheritance futex (`FUTEX_LOCK_PI`): like @ref Futex, but the kernel boosts a preempted lock holder to the
+         *  priority of its highest priority waiter and hands the lock over in priority order -- for SCHED_FIFO / SCHED_RR threads
+         *  sharing locks with lower priority ones. The spin phase, if any, is still driven by `ESpinMethod`. Note that the lock
+         *  must be unlocked by the same thread that locked it. */
+        PIFutex,
+        /** @ref Futex for `SpinLock`s placed in memory shared among processes (MAP_SHARED mappings), using the non private
+         *  futex operations. @ref AtomicFlag, @ref RMWLight, @ref Ouroboros & @ref Ticket need no such variant, as they don't
+         *  keep pointers nor rely on the kernel, while @ref MCS, @ref CLH & the `Cohort`s can't be shared. Note that the
+         *  `SpinLock`'s debug & lock order options keep process local addresses, so they should be left disabled. */
+        SharedFutex,
+        /** The same as @ref SharedFutex, but surviving the death of the lock holder: waiters take the lock over and
+         *  `SpinLock::ownerDied()` tells the guarded data may be inconsistent -- see `MTL::thread::RobustFutex`. Like
+         *  @ref PIFutex, the lock must be unlocked by the same thread that locked it. Dead owners are only detected by
+         *  sleeping waiters, so, with no hard lock fallback, spinning ends after `SpinLockRobustFutexSpinCycles`. Liveness
+         *  is checked by thread id: if the dead owner's tid gets reused by a new thread (or process) before a waiter
+         *  checks on it, the lock is never taken over -- so it is no replacement for a watchdog on long lived locks. Waiters on
+         *  other PID namespaces than the owner's never take it over. */
+        RobustFutex,
     };
 
+    /** constexpr to check if a lock strategy may 'hard_lock' with a deadline -- '_hard_lock_until()' -- parking the thread
+      * instead of spinning until the deadline */
+    template <ELockSpecializations _lockStrategy>
+    inline constexpr bool isTimedHardLockAvailable() {
+        return (_lockStrategy == ELockSpecializations::Futex)       || (_lockStrategy == ELockSpecializations::ElidedFutex) ||
+               (_lockStrategy == ELockSpecializations::SharedFutex) || (_lockStrategy == ELockSpecializations::RobustFutex)
+#if MTL_THREAD_PTHREAD_CLOCKLOCK
+            || (_lockStrategy == ELockSpecializations::Mutex)
+#endif
+            ;
+    }
+
+    /** constexpr to check if a lock strategy runs the critical sections inside hardware transactions, when possible */
+    template <ELockSpecializations _lockStrategy>
+    inline constexpr bool isElidedLockStrategy() {
+        return (_lockStrategy == ELockSpecializations::Elided) || (_lockStrategy == ELockSpecializations::ElidedFutex);
+    }
+
+    /** constexpr to check if a lock strategy is a NUMA aware cohort lock -- which hands the global lock over only to the
+      * waiters it knows of, registered by '_hard_spin()' / '_hard_lock()', but not by '_try_lock()' */
+    template <ELockSpecializations _lockStrategy>
+    inline constexpr bool isCohortLockStrategy() {
+        return (_lockStrategy == ELockSpecializations::Cohort) || (_lockStrategy == ELockSpecializations::CohortOuroboros);
+    }
+
     // pseudo base-class named 'LockSpecialization' used to build
     // both 'MutexLockSpecialization' and 'AtomicFlagLockSpecialization'
     // (no implementation of this virtual class is made because
@@ -208,15 +888,40 @@ namespace MTL::thread {
         inline void _unlock() {
             mutex.unlock();
         }
+#if MTL_THREAD_PTHREAD_CLOCKLOCK
+        /** 'deadline' is an absolute CLOCK_MONOTONIC time */
+        inline bool _hard_lock_until(const struct timespec& deadline) {
+            return pthread_mutex_clocklock(mutex.native_handle(), CLOCK_MONOTONIC, &deadline) == 0;
+        }
+#endif
     };
 
-    /** 'MTL::thread:Futex' based lock specialization. See more in [coco](@ref ELockSpecializations::Futex) */
-    template <ESpinMethod _spinMethod>
+    /** 'MTL::thread:Futex' based lock specialization -- or any other futex type sharing its interface, like `SharedFutex` &
+      * `RobustFutex`. See more in [coco](@ref ELockSpecializations::Futex) */
+    template <ESpinMethod _spinMethod, typename _Futex = Futex>
     struct FutexLockSpecialization {
-        alignas(64) Futex futex;
+        alignas(64) _Futex futex;
         inline void _hard_spin() {
-            while (!_try_lock()) {
-                helperESpinMethod<_spinMethod>();
+            if constexpr (std::is_same_v<_Futex, RobustFutex>) {
+                // spinning on a dead owner would never end: only sleeping waiters check on it
+                uint64_t spinStart = getProcessorCycleCount();
+                while (!_try_lock()) {
+                    if (getProcessorCycleCount()-spinStart > SpinLockRobustFutexSpinCycles) {
+                        futex.lock();
+                        return;
+                    }
+                    _spin_wait();
+                }
+            } else {
+                while (!_try_lock()) {
+                    _spin_wait();
+                }
+            }
+        }
+        inline void _spin_wait() {
+            int32_t current = futex.futexWord.load(std::memory_order_relaxed);
+            if (current != 0) {
+                helperESpinMethod<_spinMethod>(futex.futexWord, current);
             }
         }
         inline void _hard_lock() {
@@ -228,6 +933,42 @@ namespace MTL::thread {
         inline void _unlock() {
             futex.unlock();
         }
+        /** 'deadline' is an absolute CLOCK_MONOTONIC time */
+        inline bool _hard_lock_until(const struct timespec& deadline) {
+            return futex.lockUntil(deadline);
+        }
+        inline bool _is_locked() {
+            return futex.futexWord.load(std::memory_order_relaxed) != 0;
+        }
+    };
+
+    /** 'MTL::thread:PIFutex' based lock specialization. See more in [coco](@ref ELockSpecializations::PIFutex) */
+    template <ESpinMethod _spinMethod>
+    struct PIFutexLockSpecialization {
+        alignas(64) PIFutex futex;
+        inline void _hard_spin() {
+            while (!_try_lock()) {
+                _spin_wait();
+            }
+        }
+        inline void _spin_wait() {
+            int32_t current = futex.futexWord.load(std::memory_order_relaxed);
+            if (current != 0) {
+                helperESpinMethod<_spinMethod>(futex.futexWord, current);
+            }
+        }
+        inline void _hard_lock() {
+            futex.lock();   // sleeps on the kernel's priority ordered queue, boosting the holder, if needed
+        }
+        inline bool _try_lock() noexcept {
+            return futex.try_lock();
+        }
+        inline void _unlock() {
+            futex.unlock();
+        }
+        inline bool _is_locked() {
+            return futex.futexWord.load(std::memory_order_relaxed) != 0;
+        }
     };
 
     /** 'atomic_flag' based lock specialization  */
@@ -256,20 +997,26 @@ namespace MTL::thread {
         alignas(64) atomic_bool flag = ATOMIC_VAR_INIT(false);
         inline void _hard_spin() {
             while (!_try_lock()) {      // the double negation '!!' will be optimized out by the compiler
-            	helperESpinMethod<_spinMethod>();
+            	_spin_wait();
             }
         }
+        inline void _spin_wait() {
+            helperESpinMethod<_spinMethod>(flag, true);
+        }
         inline void _hard_lock() {
             _hard_spin();
         }
         inline bool _try_lock() noexcept {
             // this conditional will only execute the RMW `exchange` instruction when the flag will be turned from `false` to `true`.
             // when already locked, it will only execute the cheaper `atomic_load` instruction.
-            return !(flag.load(std::memory_order_relaxed) || flag.exchange(true, std::memory_order_relaxed));
+            return !(flag.load(std::memory_order_relaxed) || flag.exchange(true, std::memory_order_acquire));
         }
         inline void _unlock() {
             flag.store(false, std::memory_order_release);
         }
+        inline bool _is_locked() {
+            return flag.load(std::memory_order_relaxed);
+        }
     };
 
     /** lock specialization based on two 'atomic_unsigned's, to increase performance on machines with a high number of CPUs */
@@ -279,15 +1026,22 @@ namespace MTL::thread {
     	alignas(64) atomic_uint unlockCount = ATOMIC_VAR_INIT(0);
         inline void _hard_spin() {
             while (!_try_lock()) {      // the double negation '!!' will be optimized out by the compiler
-            	helperESpinMethod<_spinMethod>();
+            	_spin_wait();
+            }
+        }
+        /** waits for the next unlock -- which moves 'unlockCount' */
+        inline void _spin_wait() {
+            unsigned currUnlockCount = unlockCount.load(std::memory_order_relaxed);
+            if (lockCount.load(std::memory_order_relaxed) != currUnlockCount) {
+                helperESpinMethod<_spinMethod>(unlockCount, currUnlockCount);
             }
         }
         inline void _hard_lock() {
             _hard_spin();
         }
         inline bool _try_lock() noexcept {
-            unsigned currUnlockCount = unlockCount.load(std::memory_order_relaxed);
-            return lockCount.compare_exchange_strong(currUnlockCount, currUnlockCount+1, std::memory_order_release, std::memory_order_relaxed);
+            unsigned currUnlockCount = unlockCount.load(std::memory_order_acquire);
+            return lockCount.compare_exchange_strong(currUnlockCount, currUnlockCount+1, std::memory_order_acquire, std::memory_order_relaxed);
 
         }
         inline void _unlock() {
@@ -295,6 +1049,381 @@ namespace MTL::thread {
         }
     };
 
+    /** ticket lock specialization. See more in [coco](@ref ELockSpecializations::Ticket).
+      * Like @ref MCSLockSpecialization, `unlock()` may be called by any thread and is a no-op until the waiter holding the
+      * ticket being served notices it got the lock -- so unlocks issued in between can't make it lose its turn */
+    template <ESpinMethod _spinMethod>
+    struct TicketLockSpecialization {
+        static constexpr uint64_t NO_OWNER = ~(uint64_t)0;
+        alignas(64) atomic_uint            nextTicket  = ATOMIC_VAR_INIT(0);
+        alignas(64) atomic_uint            nowServing  = ATOMIC_VAR_INIT(0);
+        alignas(64) std::atomic<uint64_t>  ownerTicket = ATOMIC_VAR_INIT(NO_OWNER);    // only touched by the lock holder & unlocker
+        inline void _hard_spin() {
+            _hard_lock();
+        }
+        inline void _hard_lock() {
+            unsigned ticket = nextTicket.fetch_add(1, std::memory_order_relaxed);
+            unsigned distance;
+            unsigned serving;
+            while ((distance = ticket - (serving = nowServing.load(std::memory_order_acquire))) != 0) {
+                // proportional backoff: each one ahead of us will hold the lock for a while
+                if constexpr (_spinMethod == ESpinMethod::WaitOnAddress) {
+                    helperESpinMethod<_spinMethod>(nowServing, serving);     // sleeps until the next handover, instead
+                } else {
+                    for (unsigned i=0; i<distance; i++) {
+                        helperESpinMethod<_spinMethod>();
+                    }
+                }
+            }
+            ownerTicket.store(ticket, std::memory_order_release);
+        }
+        inline bool _try_lock() noexcept {
+            // only succeeds if no one holds nor waits for the lock -- acquiring the previous holder's release of 'nowServing'
+            unsigned ticket = nowServing.load(std::memory_order_acquire);
+            if (nextTicket.compare_exchange_strong(ticket, ticket+1, std::memory_order_acquire, std::memory_order_relaxed)) {
+                ownerTicket.store(ticket, std::memory_order_release);
+                return true;
+            }
+            return false;
+        }
+        inline void _unlock() {
+            uint64_t ticket = ownerTicket.exchange(NO_OWNER, std::memory_order_acq_rel);
+            if (ticket != NO_OWNER) {
+                nowServing.store(((unsigned)ticket)+1, std::memory_order_release);
+            }
+        }
+    };
+
+    /** queue node for @ref MCSLockSpecialization -- one per waiter, on its own cache line */
+    struct alignas(64) MCSLockNode {
+        std::atomic<MCSLockNode*> next   = ATOMIC_VAR_INIT(nullptr);
+        atomic_bool               locked = ATOMIC_VAR_INIT(false);     // the waiter spins while this is true
+        /** life cycle of the node: 'FREE' nodes may be (re)used by the thread owning them; 'IN_USE' nodes are enqueued;
+          * 'ORPHANED' nodes are still enqueued, but their thread is gone (or they were allocated for a single use), so the
+          * `unlock()` that releases them must also delete them */
+        enum EState : uint8_t {FREE, IN_USE, ORPHANED};
+        std::atomic<EState>       state  = ATOMIC_VAR_INIT(FREE);
+    };
+
+    /** per-thread pool of @ref MCSLockNode s -- allowing up to 'size' MCS locks to be held at the same time by each thread
+      * before resorting to single use nodes. Since nodes are released by whichever thread calls `unlock()` (lock & unlock may
+      * happen on different threads, like in a producer / consumer handoff), they are kept on the heap and outlive this pool
+      * if they are still enqueued when the thread exits */
+    struct MCSLockNodePool {
+        static constexpr unsigned size = 8;
+        MCSLockNode* nodes[size] = {};
+
+        inline MCSLockNode* acquire() {
+            for (unsigned i=0; i<size; i++) {
+                if (nodes[i] == nullptr) {
+                    nodes[i] = new MCSLockNode();
+                }
+                if (nodes[i]->state.load(std::memory_order_acquire) == MCSLockNode::FREE) {
+                    nodes[i]->state.store(MCSLockNode::IN_USE, std::memory_order_relaxed);
+                    return nodes[i];
+                }
+            }
+            // all pooled nodes are in use: get one to be deleted by `release()`
+            MCSLockNode* node = new MCSLockNode();
+            node->state.store(MCSLockNode::ORPHANED, std::memory_order_relaxed);
+            return node;
+        }
+
+        /** gives 'node' back to its pool -- may be called from any thread */
+        static inline void release(MCSLockNode* node) {
+            if (node->state.exchange(MCSLockNode::FREE, std::memory_order_acq_rel) == MCSLockNode::ORPHANED) {
+                delete node;
+            }
+        }
+
+        ~MCSLockNodePool() {
+            for (MCSLockNode* node : nodes) {
+                if ( (node != nullptr) && (node->state.exchange(MCSLockNode::ORPHANED, std::memory_order_acq_rel) == MCSLockNode::FREE) ) {
+                    delete node;
+                }
+            }
+        }
+    };
+    inline thread_local MCSLockNodePool mcsLockNodePool;
+
+    /** Mellor-Crummey & Scott queue lock specialization. See more in [coco](@ref ELockSpecializations::MCS).
+      * Like the other specializations, `unlock()` may be called by any thread -- and unlocking an already unlocked
+      * instance is a no-op -- so this may be used for producer / consumer handoffs as well */
+    template <ESpinMethod _spinMethod>
+    struct MCSLockSpecialization {
+        alignas(64) std::atomic<MCSLockNode*> tail      = ATOMIC_VAR_INIT(nullptr);
+        alignas(64) std::atomic<MCSLockNode*> ownerNode = ATOMIC_VAR_INIT(nullptr);      // only touched by the lock holder & unlocker
+        inline void _hard_spin() {
+            _hard_lock();
+        }
+        inline void _hard_lock() {
+            MCSLockNode* node = mcsLockNodePool.acquire();
+            node->next.store(nullptr, std::memory_order_relaxed);
+            node->locked.store(true, std::memory_order_relaxed);
+            MCSLockNode* predecessor = tail.exchange(node, std::memory_order_acq_rel);
+            if (predecessor != nullptr) {
+                predecessor->next.store(node, std::memory_order_release);
+                // spin on our own cache line until our predecessor hands the lock over to us
+                while (node->locked.load(std::memory_order_acquire)) {
+                	helperESpinMethod<_spinMethod>(node->locked, true);
+                }
+            }
+            ownerNode.store(node, std::memory_order_release);
+        }
+        inline bool _try_lock() noexcept {
+            // only grabs a node if the lock seems to be free
+            if (tail.load(std::memory_order_relaxed) != nullptr) {
+                return false;
+            }
+            MCSLockNode* node = mcsLockNodePool.acquire();
+            node->next.store(nullptr, std::memory_order_relaxed);
+            MCSLockNode* expected = nullptr;
+            if (tail.compare_exchange_strong(expected, node, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                ownerNode.store(node, std::memory_order_release);
+                return true;
+            }
+            MCSLockNodePool::release(node);
+            return false;
+        }
+        inline void _unlock() {
+            MCSLockNode* node = ownerNode.exchange(nullptr, std::memory_order_acq_rel);
+            if (node == nullptr) {
+                return;     // not locked
+            }
+            MCSLockNode* successor = node->next.load(std::memory_order_acquire);
+            if (successor == nullptr) {
+                // no known successors: try to leave the lock free...
+                MCSLockNode* expected = node;
+                if (tail.compare_exchange_strong(expected, nullptr, std::memory_order_release, std::memory_order_relaxed)) {
+                    MCSLockNodePool::release(node);
+                    return;
+                }
+                // ... but someone just enqueued: wait for it to link itself to us
+                while ((successor = node->next.load(std::memory_order_acquire)) == nullptr) {
+                    cpu_relax();
+                }
+            }
+            successor->locked.store(false, std::memory_order_release);
+            MCSLockNodePool::release(node);
+        }
+    };
+
+    /** queue node for @ref CLHLockSpecialization -- nodes migrate among threads: after acquiring a lock, a thread adopts the
+      * node of its predecessor for its next acquisition */
+    struct alignas(64) CLHLockNode {
+        atomic_bool locked = ATOMIC_VAR_INIT(false);     // successors spin while this is true
+    };
+
+    /** the spare node each thread will use for its next CLH lock acquisition. Since `try_lock()` may inspect nodes it doesn't
+      * own, nodes are never deleted while in use: exiting threads leave theirs on 'reserve', for the next threads to use */
+    struct CLHLockNodeHolder {
+        CLHLockNode* node = nullptr;
+
+        static inline std::mutex                reserveGuard;
+        static inline std::vector<CLHLockNode*> reserve;
+
+        inline CLHLockNode* get() {
+            if (unlikely (node == nullptr) ) {
+                std::lock_guard<std::mutex> guard(reserveGuard);
+                if (reserve.empty()) {
+                    node = new CLHLockNode();
+                } else {
+                    node = reserve.back();
+                    reserve.pop_back();
+                }
+            }
+            return node;
+        }
+        ~CLHLockNodeHolder() {
+            if (node != nullptr) {
+                std::lock_guard<std::mutex> guard(reserveGuard);
+                reserve.push_back(node);
+            }
+        }
+    };
+    inline thread_local CLHLockNodeHolder clhLockNodeHolder;
+
+    /** Craig, Landin & Hagersten queue lock specialization. See more in [coco](@ref ELockSpecializations::CLH).
+      * As with @ref MCSLockSpecialization, `unlock()` may be called by any thread and unlocking an unlocked instance is a no-op */
+    template <ESpinMethod _spinMethod>
+    struct CLHLockSpecialization {
+        alignas(64) std::atomic<CLHLockNode*> tail      = ATOMIC_VAR_INIT(new CLHLockNode());     // starts with an unlocked dummy node
+        alignas(64) std::atomic<CLHLockNode*> ownerNode = ATOMIC_VAR_INIT(nullptr);               // only touched by the lock holder & unlocker
+        ~CLHLockSpecialization() {
+            // when unlocked, the tail node belongs to no thread
+            delete tail.load(std::memory_order_relaxed);
+        }
+        inline void _hard_spin() {
+            _hard_lock();
+        }
+        inline void _hard_lock() {
+            CLHLockNode* node = clhLockNodeHolder.get();
+            node->locked.store(true, std::memory_order_relaxed);
+            CLHLockNode* predecessor = tail.exchange(node, std::memory_order_acq_rel);
+            _acquire(node, predecessor);
+        }
+        inline bool _try_lock() noexcept {
+            CLHLockNode* predecessor = tail.load(std::memory_order_acquire);
+            if (predecessor->locked.load(std::memory_order_relaxed)) {
+                return false;
+            }
+            CLHLockNode* node = clhLockNodeHolder.get();
+            node->locked.store(true, std::memory_order_relaxed);
+            if (!tail.compare_exchange_strong(predecessor, node, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                return false;
+            }
+            // we are enqueued: in the unlikely event 'predecessor' got recycled and re-enqueued between the load and the CAS
+            // above (ABA), it is locked again and we have to wait for it
+            _acquire(node, predecessor);
+            return true;
+        }
+        inline void _unlock() {
+            CLHLockNode* node = ownerNode.exchange(nullptr, std::memory_order_acq_rel);
+            if (node != nullptr) {
+                node->locked.store(false, std::memory_order_release);
+            }
+        }
+        inline void _acquire(CLHLockNode* node, CLHLockNode* predecessor) {
+            while (predecessor->locked.load(std::memory_order_acquire)) {
+            	helperESpinMethod<_spinMethod>(predecessor->locked, true);
+            }
+            clhLockNodeHolder.node = predecessor;      // no one else waits on our predecessor's node anymore
+            ownerNode.store(node, std::memory_order_release);
+        }
+    };
+
+    /** lock elision specialization over '_FallbackLockSpecialization' (which must provide '_is_locked()').
+      * See more in [coco](@ref ELockSpecializations::Elided) */
+    template <ESpinMethod _spinMethod, typename _FallbackLockSpecialization>
+    struct ElidedLockSpecialization: _FallbackLockSpecialization {
+        /** how many times '_hard_lock()' retries a transaction before resorting to the fallback lock */
+        static constexpr unsigned MAX_TRANSACTION_ATTEMPTS = 3;
+        /** the 'rtm_abort()' code used when the fallback lock was found taken inside the transaction */
+        static constexpr unsigned char LOCK_TAKEN_ABORT_CODE = 0xFF;
+        /** attempts to start a transaction with the fallback lock free -- which puts its lock word on our read set, so
+          * anyone taking the fallback lock aborts us. Returns false if we should resort to the fallback lock. */
+        template <unsigned _attempts, bool _waitForUnlock>
+        inline bool _try_elide() {
+            if (!isRTMAvailable()) {
+                return false;
+            }
+            for (unsigned attempt=0; attempt<_attempts; attempt++) {
+                unsigned status = rtm_begin();
+                if (status == RTM_STARTED) {
+                    if (!_FallbackLockSpecialization::_is_locked()) {
+                        return true;
+                    }
+                    rtm_abort<LOCK_TAKEN_ABORT_CODE>();
+                }
+                if ( (status & RTM_ABORT_EXPLICIT) && (rtm_abort_code(status) == LOCK_TAKEN_ABORT_CODE) ) {
+                    if constexpr (!_waitForUnlock) {
+                        return false;
+                    }
+                    // retrying while the lock is taken would just abort again
+                    while (_FallbackLockSpecialization::_is_locked()) {
+                        helperESpinMethodOn<_spinMethod>(static_cast<_FallbackLockSpecialization&>(*this));
+                    }
+                } else if ( (status & RTM_ABORT_RETRY) == 0 ) {
+                    return false;   // capacity, syscalls, ... -- no use in retrying
+                }
+            }
+            return false;
+        }
+        inline void _hard_spin() {
+            if (!_try_elide<MAX_TRANSACTION_ATTEMPTS, true>()) {
+                _FallbackLockSpecialization::_hard_spin();
+            }
+        }
+        inline void _hard_lock() {
+            if (!_try_elide<MAX_TRANSACTION_ATTEMPTS, true>()) {
+                _FallbackLockSpecialization::_hard_lock();
+            }
+        }
+        inline bool _try_lock() noexcept {
+            return _try_elide<1, false>() || _FallbackLockSpecialization::_try_lock();
+        }
+        /** an elided lock is the one whose fallback lock is free -- as it must be, since its lock word is on our read set.
+          * Note 'rtm_test()' would not do: it tells if we are in *any* transaction, which may have been started by
+          * another elided lock, while this one was taken through the fallback */
+        inline void _unlock() {
+            if (isRTMAvailable() && !_FallbackLockSpecialization::_is_locked()) {
+                rtm_end();
+            } else {
+                _FallbackLockSpecialization::_unlock();
+            }
+        }
+    };
+
+    /** cohort lock specialization over '_LockSpecialization' locks, which must allow being unlocked by any thread.
+      * See more in [coco](@ref ELockSpecializations::Cohort) */
+    template <ESpinMethod _spinMethod, typename _LockSpecialization>
+    struct CohortLockSpecialization {
+        static constexpr unsigned maxLocalHandoffs = 64;
+        static constexpr unsigned NO_OWNER         = ~0u;
+
+        struct alignas(64) Node {
+            _LockSpecialization               localLock;
+            alignas(64) std::atomic<unsigned> waiters         = ATOMIC_VAR_INIT(0);
+            bool                              globalLockOwned = false;    // only touched while holding 'localLock'
+            unsigned                          localHandoffs   = 0;        // only touched while holding 'localLock'
+        };
+
+        _LockSpecialization               globalLock;
+        std::unique_ptr<Node[]>           nodes;
+        alignas(64) std::atomic<unsigned> ownerNode = ATOMIC_VAR_INIT(NO_OWNER);    // allows 'unlock()' from any thread
+
+        CohortLockSpecialization()
+                : nodes(new Node[NumaTopology::get().nNodes]) {}
+
+        inline void _hard_spin() {
+            _hard_lock();
+        }
+        inline void _hard_lock() {
+            unsigned node  = NumaTopology::get().currentNode();
+            Node&    local = nodes[node];
+            local.waiters.fetch_add(1, std::memory_order_relaxed);
+            local.localLock._hard_spin();
+            local.waiters.fetch_sub(1, std::memory_order_relaxed);
+            if (!local.globalLockOwned) {
+                globalLock._hard_spin();
+                local.globalLockOwned = true;
+            }
+            ownerNode.store(node, std::memory_order_relaxed);
+        }
+        inline bool _try_lock() noexcept {
+            unsigned node  = NumaTopology::get().currentNode();
+            Node&    local = nodes[node];
+            if (!local.localLock._try_lock()) {
+                return false;
+            }
+            if (!local.globalLockOwned) {
+                if (!globalLock._try_lock()) {
+                    local.localLock._unlock();
+                    return false;
+                }
+                local.globalLockOwned = true;
+            }
+            ownerNode.store(node, std::memory_order_relaxed);
+            return true;
+        }
+        inline void _unlock() {
+            unsigned node = ownerNode.exchange(NO_OWNER, std::memory_order_relaxed);
+            if (node == NO_OWNER) {
+                return;     // not locked
+            }
+            Node& local = nodes[node];
+            if ( (local.waiters.load(std::memory_order_relaxed) > 0) && (local.localHandoffs < maxLocalHandoffs) ) {
+                // keep the global lock for the next waiter on this node
+                local.localHandoffs++;
+            } else {
+                local.localHandoffs   = 0;
+                local.globalLockOwned = false;
+                globalLock._unlock();
+            }
+            local.localLock._unlock();
+        }
+    };
+
     /** Type traits for returning one of the `LockSpecialization` derived classes based on provided `ELockSpecializations` enum member.
      *  (used by [SpinLock](@ref SpinLock) when determining which class should be one of it's bases) */
     template <ESpinMethod _spinMethod, ELockSpecializations _sp> struct TLockSpecialization {static_assert("false", "Unknown 'ELockSpecializations' used when attempting to get an instance of 'TLockSpecialization'. Please fix the template's type traits selection");};
@@ -303,6 +1432,16 @@ namespace MTL::thread {
     template <ESpinMethod _spinMethod> struct TLockSpecialization<_spinMethod, ELockSpecializations::AtomicFlag> {typedef AtomicFlagLockSpecialization<_spinMethod> type;};
     template <ESpinMethod _spinMethod> struct TLockSpecialization<_spinMethod, ELockSpecializations::RMWLight>   {typedef RMWLightLockSpecialization  <_spinMethod> type;};
     template <ESpinMethod _spinMethod> struct TLockSpecialization<_spinMethod, ELockSpecializations::Ouroboros>  {typedef OuroborosLockSpecialization <_spinMethod> type;};
+    template <ESpinMethod _spinMethod> struct TLockSpecialization<_spinMethod, ELockSpecializations::Ticket>     {typedef TicketLockSpecialization    <_spinMethod> type;};
+    template <ESpinMethod _spinMethod> struct TLockSpecialization<_spinMethod, ELockSpecializations::MCS>        {typedef MCSLockSpecialization       <_spinMethod> type;};
+    template <ESpinMethod _spinMethod> struct TLockSpecialization<_spinMethod, ELockSpecializations::CLH>        {typedef CLHLockSpecialization       <_spinMethod> type;};
+    template <ESpinMethod _spinMethod> struct TLockSpecialization<_spinMethod, ELockSpecializations::Elided>     {typedef ElidedLockSpecialization    <_spinMethod, RMWLightLockSpecialization<_spinMethod>> type;};
+    template <ESpinMethod _spinMethod> struct TLockSpecialization<_spinMethod, ELockSpecializations::ElidedFutex>{typedef ElidedLockSpecialization    <_spinMethod, FutexLockSpecialization<_spinMethod>>    type;};
+    template <ESpinMethod _spinMethod> struct TLockSpecialization<_spinMethod, ELockSpecializations::Cohort>     {typedef CohortLockSpecialization    <_spinMethod, RMWLightLockSpecialization<_spinMethod>> type;};
+    template <ESpinMethod _spinMethod> struct TLockSpecialization<_spinMethod, ELockSpecializations::CohortOuroboros>{typedef CohortLockSpecialization<_spinMethod, OuroborosLockSpecialization<_spinMethod>> type;};
+    template <ESpinMethod _spinMethod> struct TLockSpecialization<_spinMethod, ELockSpecializations::PIFutex>    {typedef PIFutexLockSpecialization   <_spinMethod> type;};
+    template <ESpinMethod _spinMethod> struct TLockSpecialization<_spinMethod, ELockSpecializations::SharedFutex>{typedef FutexLockSpecialization     <_spinMethod, SharedFutex> type;};
+    template <ESpinMethod _spinMethod> struct TLockSpecialization<_spinMethod, ELockSpecializations::RobustFutex>{typedef FutexLockSpecialization     <_spinMethod, RobustFutex> type;};
 
 
     /**
@@ -347,7 +1486,11 @@ namespace MTL::thread {
              /** when set to non 0, and requiring that '_opMetrics' is set, reverts the lock
                * to a system mutex whenever a spin lock wastes more than the given number of
                * CPU cycles, at the extra cost of an unconditional "mutex unlock" operation
-               * per unlock, what shouldn't provoke a contex-switch */
+               * per unlock, what shouldn't provoke a contex-switch.
+               * Use 'SpinLockAdaptiveHardLockFallback' to have that number of cycles learnt
+               * at runtime, from the recent contended acquisitions of this instance -- or
+               * 'SpinLockPreemptionAwareHardLockFallback' to, additionally, fall back as soon
+               * as the lock holder is found not to be running */
              uint64_t  _hardLockFallbackAfterCycles = !(uint64_t)0,
              /** if enabled, calls the several "(void) (size_t lockId)" functions defined
                * in the '_instrumentXXXXX' variables  */
@@ -357,15 +1500,30 @@ namespace MTL::thread {
              SpinLockCallbackSignature _instrumentLockCallback      = nullptr,
              SpinLockCallbackSignature _instrumentUnlockCallback    = nullptr,
              SpinLockCallbackSignature _instrumentBusyWaitCallback  = nullptr,
-             SpinLockCallbackSignature _instrumentMutexLockCallback = nullptr>   // enable to output to stderr debug information & activelly check for reentrancy errors
+             SpinLockCallbackSignature _instrumentMutexLockCallback = nullptr,   // enable to output to stderr debug information & activelly check for reentrancy errors
+             /** when true, keeps log2 histograms of the CPU cycles spent waiting for & holding
+               * the lock -- see 'histogramsSnapshot()' -- at the extra cost of reading the cycle
+               * counter on each operation, plus a non-RMW increment on a per-lock array */
+             bool  _histograms = false,
+             /** when true, and requiring that '_opMetrics' is set, keeps the metrics on
+               * per-thread, cache-line-padded shards, aggregated on read -- see
+               * 'metricsSnapshot()' -- making them exact under contention without adding
+               * a shared RMW to the hot path, at the cost of 'SpinLockMetricsShards'
+               * cache lines per lock */
+             bool  _shardedMetrics = false>
     class SpinLock
               /*** CONDITIONAL BASE CLASSES DECLARATION -- in order to allow conditional fields ***/
               : TLockSpecialization<_spinMethod, _lockStrategy>::type
 //              // which lock to use? spin (atomic_flag) or system mutex?
 //              : std::conditional<isMutexFallbackEnabled<_mutexFallbackAfterCycles>(),             MutexLockSpecialization<_useRelaxInstruction>,   AtomicFlagLockSpecialization<_useRelaxInstruction>>::type
               // additional class fields based on template parameters
-              , std::conditional<_opMetrics,                                                            SpinLockStandardMetricsAdditionalFields,   SpinLockStandardMetricsNoAdditionalFields>::type
-              , std::conditional<isHardLockMetricsEnabled<_opMetrics, _hardLockFallbackAfterCycles>(),  SpinLockHardLockMetricsAdditionalFields,   SpinLockHardLockMetricsNoAdditionalFields>::type
+              , std::conditional<_opMetrics && !_shardedMetrics,                                        SpinLockStandardMetricsAdditionalFields,   SpinLockStandardMetricsNoAdditionalFields>::type
+              , std::conditional<_opMetrics &&  _shardedMetrics,                                        SpinLockShardedMetricsAdditionalFields,    SpinLockShardedMetricsNoAdditionalFields>::type
+              , std::conditional<isHardLockMetricsEnabled<_opMetrics && !_shardedMetrics, _hardLockFallbackAfterCycles>(), SpinLockHardLockMetricsAdditionalFields, SpinLockHardLockMetricsNoAdditionalFields>::type
+              , std::conditional<isAdaptiveHardLockFallbackEnabled<_hardLockFallbackAfterCycles>(),     SpinLockAdaptiveFallbackAdditionalFields,  SpinLockAdaptiveFallbackNoAdditionalFields>::type
+              , std::conditional<isPreemptionAwareHardLockFallbackEnabled<_hardLockFallbackAfterCycles>(), SpinLockPreemptionAwareAdditionalFields, SpinLockPreemptionAwareNoAdditionalFields>::type
+              , std::conditional<_histograms,                                                           SpinLockHistogramsAdditionalFields,        SpinLockHistogramsNoAdditionalFields>::type
+              , std::conditional<isSpinLockDebugEnabled<_debugAfterCycles>() && SpinLockLockOrderValidation, SpinLockLockOrderAdditionalFields,    SpinLockLockOrderNoAdditionalFields>::type
     {
 
         // conditional code functionalities from the template parameters -- see the docs on the associated template parameters //
@@ -374,12 +1532,22 @@ namespace MTL::thread {
         static constexpr bool doControlledSpin           = ( (_debugAfterCycles != !(uint64_t)0) || (_hardLockFallbackAfterCycles != !(uint64_t)0) ) &&    // at least one of them are activated (non -1)
                                                            ( (_debugAfterCycles > 0)            || (_hardLockFallbackAfterCycles > 0) );                   // one of them implies waiting non-zero time
         /** specifies if pre and/or post code must be included to compute the usage this lock */
-        static constexpr bool doCollectStandardMetrics   = _opMetrics;
+        static constexpr bool doCollectMetrics           = _opMetrics;
+        static constexpr bool doCollectStandardMetrics   = _opMetrics && !_shardedMetrics;
+        static constexpr bool doCollectShardedMetrics    = _opMetrics &&  _shardedMetrics;
         /** candidate for removal -- since we may now compute 'hardLocks' on any 'XXXXSpecialization' class */
-        static constexpr bool doCollectHardLockMetrics   = isHardLockMetricsEnabled<_opMetrics, _hardLockFallbackAfterCycles>();
+        static constexpr bool doCollectHardLockMetrics   = isHardLockMetricsEnabled<doCollectStandardMetrics, _hardLockFallbackAfterCycles>();
         /** should we account for "spinning for too long" situations? */
         static constexpr bool doDebugSpinTimeouts        = isSpinLockDebugEnabled<_debugAfterCycles>();
         static constexpr bool doHardLockFallback         = isHardLockFallbackEnabled<_hardLockFallbackAfterCycles>();
+        static constexpr bool doAdaptiveHardLockFallback = isAdaptiveHardLockFallbackEnabled<_hardLockFallbackAfterCycles>();
+        static constexpr bool doPreemptionAwareFallback  = isPreemptionAwareHardLockFallbackEnabled<_hardLockFallbackAfterCycles>();
+        /** may 'try_lock_until()' park the thread, instead of spinning until the deadline? */
+        static constexpr bool doTimedHardLock            = isTimedHardLockAvailable<_lockStrategy>();
+        /** must spinning end in a 'hard_lock', even if no fallback was asked for? -- so dead `RobustFutex` owners get detected */
+        static constexpr bool doBoundedSpin              = (_lockStrategy == ELockSpecializations::RobustFutex) && !doHardLockFallback;
+        static constexpr bool doCollectHistograms        = _histograms;
+        static constexpr bool doValidateLockOrder        = doDebugSpinTimeouts && SpinLockLockOrderValidation;
         static constexpr bool doInstrumentLocks          = _instrumentLockCallback      != nullptr;
         static constexpr bool doInstrumentUnlocks        = _instrumentUnlockCallback    != nullptr;
         static constexpr bool doInstrumentBusyWaits      = _instrumentBusyWaitCallback  != nullptr;
@@ -393,6 +1561,10 @@ namespace MTL::thread {
         inline void _hard_spin() {
             TLockSpecialization<_spinMethod, _lockStrategy>::type::_hard_spin();
         }
+        /** one spin while the lock is taken -- on the lock word, for lock strategies having one */
+        inline void _spin() {
+            helperESpinMethodOn<_spinMethod>(static_cast<typename TLockSpecialization<_spinMethod, _lockStrategy>::type&>(*this));
+        }
         inline void _hard_lock() {
             TLockSpecialization<_spinMethod, _lockStrategy>::type::_hard_lock();
         }
@@ -402,6 +1574,18 @@ namespace MTL::thread {
         inline void _unlock() {
             TLockSpecialization<_spinMethod, _lockStrategy>::type::_unlock();
         }
+        inline bool _hard_lock_until(const struct timespec& deadline) {
+            return TLockSpecialization<_spinMethod, _lockStrategy>::type::_hard_lock_until(deadline);
+        }
+
+        /** the lock class, as seen by the lock order validator: all instances sharing a '_debugName' are the same */
+        inline const void* lockOrderClass() {
+            if constexpr (_debugName != nullptr) {
+                return _debugName;
+            } else {
+                return this;
+            }
+        }
 
 
     public:
@@ -413,6 +1597,10 @@ namespace MTL::thread {
                           "Template parameter '_debugAfterCycles' cannot be greater than '_hardLockFallbackAfterCycle' -- "
                           "otherwise the requested debug messages would never be shown. You must either correct the "
                           "relation or set one of them to zero.");
+            static_assert( !isElidedLockStrategy<_lockStrategy>() ||
+                           !(doCollectMetrics || doCollectHistograms || doAdaptiveHardLockFallback || doPreemptionAwareFallback),
+                          "'Elided' lock strategies can't be used along with metrics, histograms, adaptive or preemption aware "
+                          "hard lock fallbacks -- they write to shared fields inside the transaction, defeating the elision");
             // special cases
             if constexpr (doCollectStandardMetrics) {
                 SpinLockStandardMetricsAdditionalFields::reset();
@@ -420,11 +1608,29 @@ namespace MTL::thread {
             if constexpr (doCollectHardLockMetrics) {
                 SpinLockHardLockMetricsAdditionalFields::reset();
             }
+            if constexpr (doCollectShardedMetrics) {
+                SpinLockShardedMetricsAdditionalFields::reset();
+            }
+            if constexpr (doAdaptiveHardLockFallback) {
+                SpinLockAdaptiveFallbackAdditionalFields::reset();
+            }
+            if constexpr (doPreemptionAwareFallback) {
+                SpinLockPreemptionAwareAdditionalFields::reset();
+            }
+            if constexpr (doCollectHistograms) {
+                SpinLockHistogramsAdditionalFields::reset();
+            }
 /*            if constexpr (doDebugSpinTimeouts) {
                 issueDebugMessage("Just created the mutex");
             }*/
         }
 
+        ~SpinLock() {
+            if constexpr (doValidateLockOrder) {
+                SpinLockLockOrderValidator::destroyed(lockOrderClass(), this);
+            }
+        }
+
         inline void issueDebugMessage(string message) {
             stringstream c;
             if constexpr (_debugName != nullptr) {
@@ -438,6 +1644,15 @@ namespace MTL::thread {
             if constexpr (doCollectHardLockMetrics) {
                 SpinLockHardLockMetricsAdditionalFields::debugHardLockMetrics(c);
             }
+            if constexpr (doCollectShardedMetrics) {
+                SpinLockShardedMetricsAdditionalFields::debugMetrics(c, doHardLockFallback);
+            }
+            if constexpr (doAdaptiveHardLockFallback) {
+                SpinLockAdaptiveFallbackAdditionalFields::debugAdaptiveFallbackMetrics(c);
+            }
+            if constexpr (doCollectHistograms) {
+                SpinLockHistogramsAdditionalFields::debugHistograms(c);
+            }
             c << "}\n";
             std::cerr << c.str() << std::flush;
         }
@@ -452,26 +1667,50 @@ namespace MTL::thread {
             //       code is not enable in the following `if constexpr` expressions
 
             uint64_t waitingToLockStart;                // measure the cycles spent spinning
-        	if (doDebugSpinTimeouts || doHardLockFallback || doCollectStandardMetrics) {
+        	if (doDebugSpinTimeouts || doHardLockFallback || doCollectMetrics || doCollectHistograms) {
                 // 'waitingToLockStart' is used to detect when to issue a debug warning on
                 // 'spinning for too long' and 'hard_lock fallback' events.
-                // if 'doCollectStandardMetrics' is enabled, it will also be used to
+                // if 'doCollectMetrics' is enabled, it will also be used to
                 // increment 'cpuCyclesWaitingToLock' when the lock is acquired
+                // (and, if 'doCollectHistograms' is, to record on the wait cycles histogram)
                 waitingToLockStart = getProcessorCycleCount();
                 // conditional for 'lockCallsCount' and, possibly, 'cpuCyclesWaitingToLock' metrics
                 if constexpr (doCollectStandardMetrics) {
                     SpinLockStandardMetricsAdditionalFields::lockCallsCount++;
                 }
+                if constexpr (doCollectShardedMetrics) {
+                    SpinLockShardedMetricsAdditionalFields::count(&SpinLockMetricsShard::lockCallsCount);
+                }
         	}
 
 
+            // conditional for reporting lock order inversions -- before we possibly dead lock
+            if constexpr (doValidateLockOrder) {
+                SpinLockLockOrderValidator::beforeLock(lockOrderClass(), _debugName, this);
+            }
+
+
             // LOCK CODE
             ////////////
 
             bool spinningTooMuchDebugged = false;   // will be true if a "spinning for too long" debug message was issued
+            bool contended               = false;   // will be true if the first attempt to acquire the lock failed
+            bool hardLocked              = false;   // will be true if we had to fall back to 'hard_lock'ing
+
+            // how long should we spin before 'hard_lock'ing?
+            uint64_t hardLockFallbackAfterCycles;
+            if constexpr (doAdaptiveHardLockFallback) {
+                hardLockFallbackAfterCycles = SpinLockAdaptiveFallbackAdditionalFields::spinBudget();
+            } else {
+                hardLockFallbackAfterCycles = _hardLockFallbackAfterCycles;
+            }
+            SpinLockPreemptionAwareAdditionalFields::OwnerWatch ownerWatch;
+            if constexpr (doPreemptionAwareFallback) {
+                ownerWatch.nextCheck = waitingToLockStart + SpinLockPreemptionAwareAdditionalFields::checkEveryCycles;
+            }
 
             // if we don't need to do any measurements while waiting to acquire the lock, lets simply use the 'XXXXXSpecialization._hard_lock()' implementation
-            if constexpr (!doControlledSpin && !doCollectStandardMetrics) {
+            if constexpr (!doControlledSpin && !doCollectMetrics) {
                 _hard_lock();
             } else {
 
@@ -481,8 +1720,25 @@ namespace MTL::thread {
                 // do the following until we may acquire the lock...
                 while (!_try_lock())  {
 
+                    contended = true;
+
+                    // cohort locks must know we are waiting, or the global lock would never be handed over to us
+                    if constexpr (isCohortLockStrategy<_lockStrategy>()) {
+                        _hard_spin();
+                        break;
+                    }
+
                     // Do something while spinning: `cpu_relax()`, yield to another thread or simply do nothing (to test again as soon as possible)
-                	helperESpinMethod<_spinMethod>();
+                	_spin();
+
+                    // with no other spin limits, 'RobustFutex'es still fall back to sleeping, where dead owners are taken over
+                    if constexpr (doBoundedSpin && !doDebugSpinTimeouts) {
+                        if (getProcessorCycleCount()-waitingToLockStart > SpinLockRobustFutexSpinCycles) {
+                            _hard_lock();
+                            hardLocked = true;
+                            break;
+                        }
+                    }
 
                     // spin timeouts & hard_lock fall back optional codes
                     if constexpr (doDebugSpinTimeouts || doHardLockFallback) {
@@ -507,7 +1763,11 @@ namespace MTL::thread {
                         // the operating system to don't execute this thread again until otherwise stated, which will
                         // eventually be done when another thread calls their `unlock()` procedure
                         if constexpr (doHardLockFallback) {
-                            if (elapsedCycles > _hardLockFallbackAfterCycles) {
+                            bool ownerPreempted = false;
+                            if constexpr (doPreemptionAwareFallback) {
+                                ownerPreempted = SpinLockPreemptionAwareAdditionalFields::isOwnerPreempted(ownerWatch, waitingToLockStart+elapsedCycles);
+                            }
+                            if ( (elapsedCycles > hardLockFallbackAfterCycles) || ownerPreempted ) {
                                 /*** PLEASE, SEARCH THIS TAG AND KEEP THIS CODE THE SAME -- OR PUT THEM INTO A DEFINE ***/
                                 // conditional for giving a satisfaction on any eventually issue "spinning for too long" message
                                 if constexpr (doDebugSpinTimeouts) {
@@ -519,7 +1779,11 @@ namespace MTL::thread {
                                 if constexpr (doCollectHardLockMetrics) {
                                     SpinLockHardLockMetricsAdditionalFields::hardLocksCount++;
                                 }
+                                if constexpr (doCollectShardedMetrics) {
+                                    SpinLockShardedMetricsAdditionalFields::count(&SpinLockMetricsShard::hardLocksCount);
+                                }
                                 _hard_lock();	// really blocks the execution of this thread for an undefined amount of time
+                                hardLocked = true;
                                 break;
                             }
                         }
@@ -534,6 +1798,8 @@ namespace MTL::thread {
             // POS-LOCK CODE
             ////////////////
 
+            helperESpinMethodWaitEnded<_spinMethod>();
+
             // conditional for giving a satisfaction on any eventually issue "spinning for too long" message
             if constexpr (doDebugSpinTimeouts) {
                 if (spinningTooMuchDebugged) {
@@ -543,11 +1809,36 @@ namespace MTL::thread {
 
             // conditionals for after the lock has been acquired
 
+            if constexpr (doValidateLockOrder) {
+                SpinLockLockOrderValidator::acquired(lockOrderClass(), _debugName, this, SpinLockLockOrderAdditionalFields::acquisitionId);
+            }
+
+            if constexpr (doAdaptiveHardLockFallback) {
+                if (contended) {
+                    SpinLockAdaptiveFallbackAdditionalFields::learn(hardLocked ? 0 : getProcessorCycleCount()-waitingToLockStart);
+                }
+            }
+
+            if constexpr (doPreemptionAwareFallback) {
+                SpinLockPreemptionAwareAdditionalFields::publishOwner();
+            }
+
+            if constexpr (doCollectHistograms) {
+                SpinLockHistogramsAdditionalFields::histogramLockStart = getProcessorCycleCount();   // will be used to record on 'holdCyclesHistogram' when this gets unlocked
+                SpinLockHistogramsAdditionalFields::waitCyclesHistogram.record(SpinLockHistogramsAdditionalFields::histogramLockStart-waitingToLockStart);
+            }
+
             if constexpr (doCollectStandardMetrics) {
                 SpinLockStandardMetricsAdditionalFields::lockStart = getProcessorCycleCount();   // will be used to increment 'cpuCyclesLocked' when this gets unlocked
                 SpinLockStandardMetricsAdditionalFields::cpuCyclesWaitingToLock += SpinLockStandardMetricsAdditionalFields::lockStart-waitingToLockStart;
             }
 
+            if constexpr (doCollectShardedMetrics) {
+                uint64_t lockStart = getProcessorCycleCount();
+                SpinLockShardedMetricsAdditionalFields::lockStart.store(lockStart, std::memory_order_relaxed);     // will be used to count 'cpuCyclesLocked' when this gets unlocked
+                SpinLockShardedMetricsAdditionalFields::count(&SpinLockMetricsShard::cpuCyclesWaitingToLock, lockStart-waitingToLockStart);
+            }
+
         }
 
 
@@ -555,11 +1846,32 @@ namespace MTL::thread {
             
             if constexpr (doCollectStandardMetrics) {
                 SpinLockStandardMetricsAdditionalFields::tryLocksCount++;
+            }
+            if constexpr (doCollectShardedMetrics) {
+                SpinLockShardedMetricsAdditionalFields::count(&SpinLockMetricsShard::tryLocksCount);
+            }
+
+            if constexpr (doCollectMetrics || doPreemptionAwareFallback || doCollectHistograms || doValidateLockOrder) {
                 // are we already locked?
                 if (unlikely (!_try_lock()) ) {
                     return false;
                 }
-                SpinLockStandardMetricsAdditionalFields::lockStart = getProcessorCycleCount();   // will be used to increment 'cpuCyclesLocked' when this gets unlocked
+                if constexpr (doValidateLockOrder) {
+                    // 'try_lock()' can't dead lock, so no order is validated -- but the lock will be considered held from now on
+                    SpinLockLockOrderValidator::acquired(lockOrderClass(), _debugName, this, SpinLockLockOrderAdditionalFields::acquisitionId);
+                }
+                if constexpr (doPreemptionAwareFallback) {
+                    SpinLockPreemptionAwareAdditionalFields::publishOwner();
+                }
+                if constexpr (doCollectHistograms) {
+                    SpinLockHistogramsAdditionalFields::histogramLockStart = getProcessorCycleCount();   // will be used to record on 'holdCyclesHistogram' when this gets unlocked
+                }
+                if constexpr (doCollectStandardMetrics) {
+                    SpinLockStandardMetricsAdditionalFields::lockStart = getProcessorCycleCount();   // will be used to increment 'cpuCyclesLocked' when this gets unlocked
+                }
+                if constexpr (doCollectShardedMetrics) {
+                    SpinLockShardedMetricsAdditionalFields::lockStart.store(getProcessorCycleCount(), std::memory_order_relaxed);
+                }
                 return true;
             }
 
@@ -567,8 +1879,134 @@ namespace MTL::thread {
         }
 
 
+        /** like 'lock()', but gives up -- returning false -- if the lock couldn't be acquired until 'deadline': spins for up to
+          * '_hardLockFallbackAfterCycles' (reading the clock only every 'SpinLockTimedLockClockCheckCycles') and then, on lock
+          * strategies allowing it (see 'isTimedHardLockAvailable()'), parks the thread with an absolute CLOCK_MONOTONIC timeout
+          * -- on the others, keeps on spinning until the deadline. Along with 'try_lock_for()', makes this a `TimedLockable` */
+        template <typename _Clock, typename _Duration>
+        inline bool try_lock_until(const std::chrono::time_point<_Clock, _Duration>& deadline) {
+
+            if constexpr (doCollectStandardMetrics) {
+                SpinLockStandardMetricsAdditionalFields::tryLocksCount++;
+            }
+            if constexpr (doCollectShardedMetrics) {
+                SpinLockShardedMetricsAdditionalFields::count(&SpinLockMetricsShard::tryLocksCount);
+            }
+
+            uint64_t waitingToLockStart = getProcessorCycleCount();
+            bool     contended          = false;   // will be true if the first attempt to acquire the lock failed
+            bool     hardLocked         = false;   // will be true if we had to fall back to '_hard_lock_until()'
+
+            if (!_try_lock()) {
+
+                contended = true;
+                std::chrono::steady_clock::time_point steadyDeadline = FutexAdapter::toSteadyDeadline(deadline);
+
+                // how long should we spin before parking? (like 'lock()', straight away if there is no hard lock fallback)
+                uint64_t spinCycles;
+                if constexpr (doAdaptiveHardLockFallback) {
+                    spinCycles = SpinLockAdaptiveFallbackAdditionalFields::spinBudget();
+                } else if constexpr (doHardLockFallback) {
+                    spinCycles = _hardLockFallbackAfterCycles;
+                } else {
+                    spinCycles = 0;
+                }
+
+                uint64_t nextClockCheck = waitingToLockStart + SpinLockTimedLockClockCheckCycles;
+                do {
+                    uint64_t now = getProcessorCycleCount();
+                    if constexpr (doTimedHardLock) {
+                        if ((now - waitingToLockStart) >= spinCycles) {
+                            if constexpr (doCollectHardLockMetrics) {
+                                SpinLockHardLockMetricsAdditionalFields::hardLocksCount++;
+                            }
+                            if constexpr (doCollectShardedMetrics) {
+                                SpinLockShardedMetricsAdditionalFields::count(&SpinLockMetricsShard::hardLocksCount);
+                            }
+                            if (!_hard_lock_until(FutexAdapter::toMonotonicDeadline(steadyDeadline))) {
+                                helperESpinMethodWaitEnded<_spinMethod>();
+                                return false;
+                            }
+                            hardLocked = true;
+                            break;
+                        }
+                    }
+                    if (now >= nextClockCheck) {
+                        if (std::chrono::steady_clock::now() >= steadyDeadline) {
+                            helperESpinMethodWaitEnded<_spinMethod>();
+                            return false;
+                        }
+                        nextClockCheck = now + SpinLockTimedLockClockCheckCycles;
+                    }
+                    _spin();
+                } while (!_try_lock());
+                helperESpinMethodWaitEnded<_spinMethod>();
+            }
+
+            // POS-LOCK CODE -- the same as 'lock()', except for the lock order validation: timing out, we can't dead lock
+            if constexpr (doValidateLockOrder) {
+                SpinLockLockOrderValidator::acquired(lockOrderClass(), _debugName, this, SpinLockLockOrderAdditionalFields::acquisitionId);
+            }
+            if constexpr (doAdaptiveHardLockFallback) {
+                if (contended) {
+                    SpinLockAdaptiveFallbackAdditionalFields::learn(hardLocked ? 0 : getProcessorCycleCount()-waitingToLockStart);
+                }
+            }
+            if constexpr (doPreemptionAwareFallback) {
+                SpinLockPreemptionAwareAdditionalFields::publishOwner();
+            }
+            if constexpr (doCollectHistograms) {
+                SpinLockHistogramsAdditionalFields::histogramLockStart = getProcessorCycleCount();   // will be used to record on 'holdCyclesHistogram' when this gets unlocked
+                SpinLockHistogramsAdditionalFields::waitCyclesHistogram.record(SpinLockHistogramsAdditionalFields::histogramLockStart-waitingToLockStart);
+            }
+            if constexpr (doCollectStandardMetrics) {
+                SpinLockStandardMetricsAdditionalFields::lockStart = getProcessorCycleCount();   // will be used to increment 'cpuCyclesLocked' when this gets unlocked
+                SpinLockStandardMetricsAdditionalFields::cpuCyclesWaitingToLock += SpinLockStandardMetricsAdditionalFields::lockStart-waitingToLockStart;
+            }
+            if constexpr (doCollectShardedMetrics) {
+                uint64_t lockStart = getProcessorCycleCount();
+                SpinLockShardedMetricsAdditionalFields::lockStart.store(lockStart, std::memory_order_relaxed);     // will be used to count 'cpuCyclesLocked' when this gets unlocked
+                SpinLockShardedMetricsAdditionalFields::count(&SpinLockMetricsShard::cpuCyclesWaitingToLock, lockStart-waitingToLockStart);
+            }
+            return true;
+        }
+
+        template <typename _Rep, typename _Period>
+        inline bool try_lock_for(const std::chrono::duration<_Rep, _Period>& timeout) {
+            return try_lock_until(std::chrono::steady_clock::now() + timeout);
+        }
+
+
         inline void unlock() {
 
+            if constexpr (doValidateLockOrder) {
+                SpinLockLockOrderValidator::released(SpinLockLockOrderAdditionalFields::acquisitionId);
+            }
+
+            if constexpr (doPreemptionAwareFallback) {
+                SpinLockPreemptionAwareAdditionalFields::unpublishOwner();
+            }
+
+            // conditional for 'unlockCallsCount' and 'cpuCyclesLocked' sharded metrics -- computed while still holding the lock
+            if constexpr (doCollectShardedMetrics) {
+                SpinLockShardedMetricsAdditionalFields::count(&SpinLockMetricsShard::unlockCallsCount);
+                // were we really locked?
+                uint64_t lockStart = SpinLockShardedMetricsAdditionalFields::lockStart.load(std::memory_order_relaxed);
+                if (likely (lockStart != !(uint64_t)0) ) {
+                    SpinLockShardedMetricsAdditionalFields::count(&SpinLockMetricsShard::cpuCyclesLocked, getProcessorCycleCount() - lockStart);
+                    SpinLockShardedMetricsAdditionalFields::lockStart.store(!(uint64_t)0, std::memory_order_relaxed);     // get back to the special value denoting we are unlocked
+                }
+            }
+
+            // recorded while still holding the lock -- so the histogram has a single writer
+            if constexpr (doCollectHistograms) {
+                // were we really locked?
+                if (likely (SpinLockHistogramsAdditionalFields::histogramLockStart != !(uint64_t)0) ) {
+                    SpinLockHistogramsAdditionalFields::holdCyclesHistogram.record(getProcessorCycleCount() - SpinLockHistogramsAdditionalFields::histogramLockStart);
+                    SpinLockHistogramsAdditionalFields::histogramLockStart = !(uint64_t)0;     // get back to the special value denoting we are unlocked
+                }
+            }
+
             _unlock();
 
             // conditional for 'unlockCallsCount', 'realUnlocksCount' and 'cpuCyclesLocked' metrics
@@ -582,10 +2020,33 @@ namespace MTL::thread {
             }
         }
 
+        /** tells the lock holder if the lock was taken over from a thread (or process) which died holding it -- in which case
+          * the guarded data may be inconsistent. Requires the 'RobustFutex' lock strategy */
+        inline bool ownerDied() {
+            static_assert(_lockStrategy == ELockSpecializations::RobustFutex, "'ownerDied()' requires the 'RobustFutex' lock strategy");
+            return TLockSpecialization<_spinMethod, _lockStrategy>::type::futex.ownerDied();
+        }
+
+        /** returns the metrics aggregated from all threads' shards -- may be called from any thread, at any time.
+          * Requires both the '_opMetrics' & '_shardedMetrics' template parameters */
+        inline SpinLockMetricsSnapshot metricsSnapshot() const {
+            static_assert(doCollectShardedMetrics, "'metricsSnapshot()' requires both the '_opMetrics' & '_shardedMetrics' template parameters to be true");
+            return SpinLockShardedMetricsAdditionalFields::aggregate();
+        }
+
+        /** returns the p50/p99/p999 of the cycles spent waiting for & holding this lock -- may be called from any thread,
+          * at any time, without disturbing the lock users. Requires the '_histograms' template parameter */
+        inline SpinLockHistogramsSnapshot histogramsSnapshot() const {
+            static_assert(doCollectHistograms, "'histogramsSnapshot()' requires the '_histograms' template parameter to be true");
+            return {SpinLockHistogramsAdditionalFields::waitCyclesHistogram.snapshot(),
+                    SpinLockHistogramsAdditionalFields::holdCyclesHistogram.snapshot()};
+        }
+
     };
 }
 
 #undef likely
 #undef unlikely
+#undef MTL_THREAD_PTHREAD_CLOCKLOCK
 
 #endif /* MTL_THREAD_SpinLock_hpp_ */
@@ -0,0 +1,70 @@
+/*! \file ThreadSlotIndex.hpp
+    \brief Gives each live thread a small, dense index, for per-thread slots on shared structures.
+
+    Used to shard data among threads -- so each one may update its own slot with plain loads & stores (no RMW), on its
+    own cache line -- as done by `SpinLock`'s sharded metrics, `FlatCombiner` and `LatencyRecorder`.
+*/
+
+#ifndef MTL_THREAD_ThreadSlotIndex_hpp_
+#define MTL_THREAD_ThreadSlotIndex_hpp_
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+
+namespace MTL::thread {
+
+    /** how many per-thread slots structures indexed by @ref ThreadSlotIndex should keep */
+    constexpr unsigned ThreadSlots = 64;
+
+    /**
+     * ThreadSlotIndex.hpp
+     * ===================
+     *
+     * Gives each thread, while alive, exclusive use of one of the indexes in [0, 'ThreadSlots'-1) -- the same on every
+     * structure using them -- reused by other threads once it exits. Threads beyond that share the last index,
+     * 'ThreadSlots'-1, and must update it with RMW instructions (or by any other means not assuming exclusivity).
+     *
+     * Usage:
+     *     const ThreadSlotIndex& slot = threadSlotIndex;      // assigned on the first use by each thread
+     *     if (slot.exclusive) { ...plain load & store on slots[slot.index]... } else { ...fetch_add... }
+     *
+    */
+    struct ThreadSlotIndex {
+        unsigned index;
+        bool     exclusive;
+
+        static std::mutex& mutex() {
+            static std::mutex slotsMutex;
+            return slotsMutex;
+        }
+        static std::vector<bool>& inUse() {
+            static std::vector<bool> slotsInUse(ThreadSlots-1, false);
+            return slotsInUse;
+        }
+
+        ThreadSlotIndex() {
+            std::lock_guard<std::mutex> guard(mutex());
+            std::vector<bool>& used = inUse();
+            auto free = std::find(used.begin(), used.end(), false);
+            exclusive = free != used.end();
+            if (exclusive) {
+                index = free - used.begin();
+                *free = true;
+            } else {
+                index = ThreadSlots-1;
+            }
+        }
+
+        ~ThreadSlotIndex() {
+            if (exclusive) {
+                std::lock_guard<std::mutex> guard(mutex());
+                inUse()[index] = false;
+            }
+        }
+    };
+    inline thread_local ThreadSlotIndex threadSlotIndex;
+}
+
+#endif /* MTL_THREAD_ThreadSlotIndex_hpp_ */
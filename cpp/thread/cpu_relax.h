@@ -8,6 +8,12 @@
  *  designed to be used in spin loops (PAUSE for x86 and YIELD for ARM), for
  *  their ability to preserve some power (and heat) while freeing the core'
  *  busses to execute code from another CPU.
+ *
+ *  Also provides `cpu_wait_on_address()`, which goes further by putting the
+ *  core in a low power state until a cache line is written -- UMONITOR/UMWAIT,
+ *  on Intel CPUs having WAITPKG (checked at runtime), or WFE, on ARMv8 --
+ *  falling back to `cpu_relax()` elsewhere. With no address to watch, there
+ *  is nothing to wake a sleeping core up in time, so use `cpu_relax()`.
  */
 
 #ifndef GITHUB_CPP_THREAD_cpu_relax_h_
@@ -18,7 +24,7 @@
 //////////////////////////////////////////////////////////////////////
 #if __x86_64
     #define cpu_relax() asm volatile ("pause" ::: "memory");
-#elif  __arm__
+#elif  __arm__ || __aarch64__
     #define cpu_relax() asm volatile ("yield" ::: "memory");
 #else
     #error Unknown CPU. Please, update cpu_relax.h
@@ -26,5 +32,87 @@
 //////////////////////////////////////////////////////////////////////
 
 
+#ifdef __cplusplus
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include "../compiletime/HostInfo.h"
+
+#if MTL_CPU_INSTR_WAITPKG
+    #include <cpuid.h>
+#endif
+
+namespace MTL::thread {
+
+    /** how many TSC cycles, at most, each `cpu_wait_on_address()` may sleep on x86 -- so callers
+      * checking for timeouts still do it often. On ARMv8, WFE is bound by the kernel's timer event stream (~100us) */
+    constexpr uint64_t CPU_WAIT_MAX_CYCLES = 10'000;
+
+#if MTL_CPU_INSTR_WAITPKG
+
+    /** CPUID.(EAX=7,ECX=0):ECX bit 5 -- checked only once per process */
+    inline bool isWaitPkgAvailable() {
+        static const bool waitPkgAvailable = [] {
+            unsigned eax, ebx, ecx, edx;
+            return __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ecx & (1 << 5));
+        }();
+        return waitPkgAvailable;
+    }
+
+    /** UMONITOR: arms the monitor on the cache line of 'address' */
+    inline void cpu_umonitor(const volatile void* address) {
+        asm volatile (".byte 0xf3,0x0f,0xae,0xf0" :: "a" (address) : "memory");
+    }
+
+    /** UMWAIT: sleeps, on the C0.1 state (the fastest to wake up from), until the monitored cache line is written or the
+      * TSC reaches 'deadline' */
+    inline void cpu_umwait(uint64_t deadline) {
+        asm volatile (".byte 0xf2,0x0f,0xae,0xf1" :: "c" (1), "a" ((uint32_t)deadline), "d" ((uint32_t)(deadline >> 32)) : "memory", "cc");
+    }
+
+#endif
+
+    /** waits, on a low power state if the CPU allows it, while 'word' seems to hold 'current' -- returning as soon as its
+      * cache line is written, on a timeout or, sometimes, spuriously: callers must always check 'word' again */
+    template <typename _T>
+    inline void cpu_wait_on_address(const std::atomic<_T>& word, _T current) {
+#if MTL_CPU_INSTR_WAITPKG
+        if (isWaitPkgAvailable()) {
+            cpu_umonitor(&word);
+            // armed before this load, so any later write wakes us up
+            if (word.load(std::memory_order_relaxed) == current) {
+                cpu_umwait(__builtin_ia32_rdtsc() + CPU_WAIT_MAX_CYCLES);
+            }
+        } else {
+            cpu_relax();
+        }
+#elif __aarch64__
+        static_assert(sizeof(_T) == 1 || sizeof(_T) == 4 || sizeof(_T) == 8, "'cpu_wait_on_address()' requires 1, 4 or 8 bytes words");
+        // the exclusive load arms the monitor, whose clearing -- by any write to the cache line -- ends the WFE
+        uint64_t value;
+        uint64_t expected = 0;
+        std::memcpy(&expected, &current, sizeof(_T));
+        if constexpr (sizeof(_T) == 1) {
+            asm volatile ("ldaxrb %w0, [%1]" : "=&r" (value) : "r" (&word) : "memory");
+        } else if constexpr (sizeof(_T) == 4) {
+            asm volatile ("ldaxr %w0, [%1]" : "=&r" (value) : "r" (&word) : "memory");
+        } else {
+            asm volatile ("ldaxr %0, [%1]" : "=&r" (value) : "r" (&word) : "memory");
+        }
+        if (value == expected) {
+            asm volatile ("wfe" ::: "memory");
+        }
+#else
+        (void)word;
+        (void)current;
+        cpu_relax();
+#endif
+    }
+
+}
+
+#endif
+
 
 #endif /* GITHUB_CPP_THREAD_cpu_relax_h_ */
@@ -0,0 +1,85 @@
+/**
+ * rtm.h
+ *
+ *  Provides Intel's Restricted Transactional Memory (TSX/RTM) instructions
+ *  as inline functions -- emitted as raw opcodes, so no '-mrtm' is needed and
+ *  the calling code may still be inlined into code compiled for any x86_64.
+ *  Since most CPUs lack (or have disabled) TSX, 'isRTMAvailable()' must be
+ *  checked before using them -- on other architectures, it is constexpr false.
+ */
+
+#ifndef GITHUB_CPP_THREAD_rtm_h_
+#define GITHUB_CPP_THREAD_rtm_h_
+
+#include "../compiletime/HostInfo.h"
+
+#if MTL_CPU_INSTR_RTM
+    #include <cpuid.h>
+#endif
+
+
+namespace MTL::thread {
+
+    /** returned by 'rtm_begin()' when the transaction started -- otherwise, the abort status is returned */
+    constexpr unsigned RTM_STARTED          = ~0u;
+    /** abort status bits */
+    constexpr unsigned RTM_ABORT_EXPLICIT   = 1 << 0;
+    constexpr unsigned RTM_ABORT_RETRY      = 1 << 1;
+    constexpr unsigned RTM_ABORT_CONFLICT   = 1 << 2;
+    constexpr unsigned RTM_ABORT_CAPACITY   = 1 << 3;
+    /** the code given to 'rtm_abort<_code>()', when 'RTM_ABORT_EXPLICIT' is set */
+    constexpr unsigned rtm_abort_code(unsigned status) {
+        return (status >> 24) & 0xFF;
+    }
+
+#if MTL_CPU_INSTR_RTM
+
+    /** CPUID.(EAX=7,ECX=0):EBX bit 11 (RTM) and not EDX bit 11 (RTM_ALWAYS_ABORT, set by microcode updates which keep
+      * the instructions but make every 'rtm_begin()' abort) -- checked only once per process */
+    inline bool isRTMAvailable() {
+        static const bool rtmAvailable = [] {
+            unsigned eax, ebx, ecx, edx;
+            return __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & (1 << 11)) && !(edx & (1 << 11));
+        }();
+        return rtmAvailable;
+    }
+
+    /** XBEGIN: returns 'RTM_STARTED' or, if the transaction aborted, the abort status */
+    inline unsigned rtm_begin() {
+        unsigned status = RTM_STARTED;
+        asm volatile (".byte 0xc7,0xf8 ; .long 0" : "+a" (status) :: "memory");
+        return status;
+    }
+
+    /** XEND: commits the transaction */
+    inline void rtm_end() {
+        asm volatile (".byte 0x0f,0x01,0xd5" ::: "memory");
+    }
+
+    /** XABORT: rolls the transaction back, making 'rtm_begin()' return with 'RTM_ABORT_EXPLICIT' & '_code' */
+    template <unsigned char _code>
+    inline void rtm_abort() {
+        asm volatile (".byte 0xc6,0xf8,%P0" :: "i" (_code) : "memory");
+    }
+
+    /** XTEST: tells if we are inside a transaction */
+    inline bool rtm_test() {
+        unsigned char inTransaction;
+        asm volatile (".byte 0x0f,0x01,0xd6 ; setnz %0" : "=r" (inTransaction) :: "memory");
+        return inTransaction;
+    }
+
+#else
+
+    constexpr bool     isRTMAvailable()  { return false; }
+    inline    unsigned rtm_begin()       { return 0; }
+    inline    void     rtm_end()         {}
+    template <unsigned char _code>
+    inline    void     rtm_abort()       {}
+    inline    bool     rtm_test()        { return false; }
+
+#endif
+
+}
+
+#endif /* GITHUB_CPP_THREAD_rtm_h_ */
@@ -0,0 +1,252 @@
+/*! \file LatencyRecorder.hpp
+    \brief HDR style latency histograms, recorded per thread with no shared writes and merged on read.
+
+    For measuring every queue hop or lock acquisition in production: recording costs a couple of cycle counter reads and
+    an increment on a cache line only the recording thread writes to, so percentiles (up to p99.9 and beyond) are not
+    distorted by the act of measuring them.
+*/
+
+#ifndef MTL_TIME_LatencyRecorder_hpp_
+#define MTL_TIME_LatencyRecorder_hpp_
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "TimeMeasurements.hpp"
+#include "../thread/ThreadSlotIndex.hpp"
+
+
+namespace MTL::time {
+
+    /**
+     * LatencyRecorder.hpp
+     * ===================
+     *
+     * Histogram of 'getProcessorCycleCount()' deltas with log-linear buckets, as HdrHistogram's: values below
+     * 2^'_subBucketBits' get a bucket each, while each power of 2 range above that is split in 2^'_subBucketBits' equal
+     * buckets -- so any recorded value is known within a relative error of 2^-'_subBucketBits' (3.1% for the default 5),
+     * from 0 up to 2^64-1, with (65-'_subBucketBits') * 2^'_subBucketBits' buckets.
+     *
+     * Each thread records on its own cache-line-aligned bucket set (allocated on its first record, at the index given by
+     * its `MTL::thread::ThreadSlotIndex`) with plain relaxed loads & stores -- no RMW instructions, no shared cache lines.
+     * Threads beyond 'ThreadSlots-1' share the last set, recording on it with 'fetch_add'. Meanwhile, 'snapshot()' may be
+     * called from any thread, at any time, merging all sets without stopping the recorders. Bucket sets outlive the
+     * threads that used them, so no samples are lost when threads exit.
+     *
+     * Usage:
+     *     LatencyRecorder<> dequeueLatency;
+     *     ...
+     *     uint64_t start = getProcessorCycleCount();
+     *     queue.dequeue();
+     *     dequeueLatency.recordSince(start);
+     *     ...
+     *     auto snapshot = dequeueLatency.snapshot();
+     *     uint64_t p999Ns = TimeMeasurements::TscClock::cyclesToNs(snapshot.valueAtPerMille(999));
+     *
+    */
+    template<
+             /** log2 of how many linear buckets each power of 2 range is split in -- the precision */
+             unsigned _subBucketBits = 5>
+    class LatencyRecorder {
+
+        static_assert(_subBucketBits >= 1 && _subBucketBits <= 16, "LatencyRecorder: '_subBucketBits' must be in [1, 16]");
+
+    public:
+
+        static constexpr unsigned nSubBuckets = 1u << _subBucketBits;
+        static constexpr unsigned nBuckets    = (65 - _subBucketBits) * nSubBuckets;
+
+        /** bucket where 'value' is counted */
+        static constexpr unsigned bucketIndex(uint64_t value) {
+            unsigned msb = 63 - __builtin_clzll(value | 1);
+            if (msb < _subBucketBits) {
+                return (unsigned)value;
+            }
+            unsigned shift = msb - _subBucketBits;
+            return ((shift+1) << _subBucketBits) + (unsigned)(value >> shift) - nSubBuckets;
+        }
+
+        /** the smallest value counted on 'bucket' */
+        static constexpr uint64_t bucketLowestValue(unsigned bucket) {
+            if (bucket < nSubBuckets) {
+                return bucket;
+            }
+            unsigned shift = (bucket >> _subBucketBits) - 1;
+            return (uint64_t)(nSubBuckets + (bucket & (nSubBuckets-1))) << shift;
+        }
+
+        /** the greatest value counted on 'bucket' */
+        static constexpr uint64_t bucketHighestValue(unsigned bucket) {
+            if (bucket < nSubBuckets) {
+                return bucket;
+            }
+            unsigned shift = (bucket >> _subBucketBits) - 1;
+            return bucketLowestValue(bucket) + (((uint64_t)1 << shift) - 1);
+        }
+
+        /** the merged buckets of all threads, as taken by 'snapshot()' -- may be merged with ('+=') other recorders' snapshots
+          * or subtracted ('-=') from a later snapshot of the same recorder, giving the histogram of that interval */
+        struct Snapshot {
+            std::array<uint64_t, nBuckets> counts;
+            uint64_t                       count;
+
+            /** the value below (or at) which 'perMille'/1000 of the samples fall -- reported as the greatest value of
+              * its bucket, so it is never underestimated. 0 for empty histograms */
+            inline uint64_t valueAtPerMille(uint64_t perMille) const {
+                uint64_t rank       = std::max<uint64_t>(1, (count*perMille + 999) / 1000);
+                uint64_t cumulative = 0;
+                for (unsigned i=0; i<nBuckets; i++) {
+                    cumulative += counts[i];
+                    if (cumulative >= rank) {
+                        return bucketHighestValue(i);
+                    }
+                }
+                return 0;   // empty histogram
+            }
+
+            inline uint64_t min() const {
+                for (unsigned i=0; i<nBuckets; i++) {
+                    if (counts[i] != 0) {
+                        return bucketLowestValue(i);
+                    }
+                }
+                return 0;
+            }
+
+            inline uint64_t max() const {
+                for (unsigned i=nBuckets; i-- > 0; ) {
+                    if (counts[i] != 0) {
+                        return bucketHighestValue(i);
+                    }
+                }
+                return 0;
+            }
+
+            /** the mean, taking each sample as the middle of its bucket */
+            inline double mean() const {
+                double sum = 0;
+                for (unsigned i=0; i<nBuckets; i++) {
+                    if (counts[i] != 0) {
+                        sum += counts[i] * ( (bucketLowestValue(i) / 2.0) + (bucketHighestValue(i) / 2.0) );
+                    }
+                }
+                return count == 0 ? 0 : sum / count;
+            }
+
+            inline Snapshot& operator += (const Snapshot& other) {
+                for (unsigned i=0; i<nBuckets; i++) {
+                    counts[i] += other.counts[i];
+                }
+                count += other.count;
+                return *this;
+            }
+
+            inline Snapshot& operator -= (const Snapshot& earlier) {
+                for (unsigned i=0; i<nBuckets; i++) {
+                    counts[i] -= earlier.counts[i];
+                }
+                count -= earlier.count;
+                return *this;
+            }
+        };
+
+    private:
+
+        struct alignas(64) Buckets {
+            std::atomic<uint64_t> counts[nBuckets];
+
+            Buckets() {
+                for (std::atomic<uint64_t>& bucketCount : counts) {
+                    bucketCount.store(0, std::memory_order_relaxed);
+                }
+            }
+        };
+
+        /** threadBuckets[threadSlotIndex.index] := the thread's bucket set -- allocated (and only ever written)
+          * by its owner, but the shared last one, which is allocated upfront */
+        alignas(64) std::atomic<Buckets*> threadBuckets[MTL::thread::ThreadSlots];
+
+        /** allocates the calling thread's bucket set, on its first record */
+        Buckets* allocateBuckets(unsigned index) {
+            Buckets* buckets = new Buckets();
+            threadBuckets[index].store(buckets, std::memory_order_release);
+            return buckets;
+        }
+
+    public:
+
+        LatencyRecorder() {
+            for (unsigned i=0; i<MTL::thread::ThreadSlots-1; i++) {
+                threadBuckets[i].store(nullptr, std::memory_order_relaxed);
+            }
+            threadBuckets[MTL::thread::ThreadSlots-1].store(new Buckets(), std::memory_order_release);
+        }
+
+        ~LatencyRecorder() {
+            for (std::atomic<Buckets*>& buckets : threadBuckets) {
+                delete buckets.load(std::memory_order_acquire);
+            }
+        }
+
+        LatencyRecorder(const LatencyRecorder&)            = delete;
+        LatencyRecorder& operator=(const LatencyRecorder&) = delete;
+
+        /** counts 'cycles' -- typically the difference between two 'getProcessorCycleCount()'s -- on the calling thread's buckets */
+        inline void record(uint64_t cycles) {
+            const MTL::thread::ThreadSlotIndex& threadIndex = MTL::thread::threadSlotIndex;
+            Buckets* buckets = threadBuckets[threadIndex.index].load(std::memory_order_relaxed);
+            if (__builtin_expect(buckets == nullptr, 0)) {
+                buckets = allocateBuckets(threadIndex.index);
+            }
+            std::atomic<uint64_t>& bucketCount = buckets->counts[bucketIndex(cycles)];
+            if (__builtin_expect(threadIndex.exclusive, 1)) {
+                bucketCount.store(bucketCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            } else {
+                bucketCount.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        /** records the cycles elapsed since 'start' -- as returned by 'getProcessorCycleCount()' */
+        inline void recordSince(uint64_t start) {
+            record(TimeMeasurements::getProcessorCycleCount() - start);
+        }
+
+        /** merges all threads' buckets -- may be called by any thread, while others record. Each bucket is read once, so
+          * samples recorded meanwhile may or may not be included, but never partially */
+        inline Snapshot snapshot() const {
+            Snapshot snapshot;
+            snapshot.counts.fill(0);
+            snapshot.count = 0;
+            for (const std::atomic<Buckets*>& threadBucketsEntry : threadBuckets) {
+                const Buckets* buckets = threadBucketsEntry.load(std::memory_order_acquire);
+                if (buckets == nullptr) {
+                    continue;
+                }
+                for (unsigned i=0; i<nBuckets; i++) {
+                    uint64_t bucketCount = buckets->counts[i].load(std::memory_order_relaxed);
+                    snapshot.counts[i] += bucketCount;
+                    snapshot.count     += bucketCount;
+                }
+            }
+            return snapshot;
+        }
+
+        /** zeroes all buckets -- only exact when no thread is recording: a concurrent record may undo the zeroing of its
+          * bucket. To get per-interval histograms from a live recorder, subtract snapshots instead */
+        inline void reset() {
+            for (std::atomic<Buckets*>& threadBucketsEntry : threadBuckets) {
+                Buckets* buckets = threadBucketsEntry.load(std::memory_order_acquire);
+                if (buckets != nullptr) {
+                    for (std::atomic<uint64_t>& bucketCount : buckets->counts) {
+                        bucketCount.store(0, std::memory_order_relaxed);
+                    }
+                }
+            }
+        }
+
+    };
+}
+
+#endif /* MTL_TIME_LatencyRecorder_hpp_ */
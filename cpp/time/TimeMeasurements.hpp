@@ -3,9 +3,16 @@
 
 #include <time.h>
 #include <sys/time.h>
+#include <sched.h>
+#include <cstdint>
+#include <chrono>
 
 #include "../compiletime/HostInfo.h"
 
+#ifdef __x86_64
+    #include <cpuid.h>
+#endif
+
 /**
  * TimeMeasurements.hpp
  * ====================
@@ -13,7 +20,9 @@
  *
  * Elapsed Real Time measurement functions -- milli, micro, nano and even less seconds.
  *
- * With the exception of 'getProcessorCycleCount', no other function here is reentrant.
+ * All functions here are reentrant and allocation free. The 'getCoarse*TimeMS()' ones use the CLOCK_*_COARSE clocks
+ * (falling back to the regular ones where not available), which are served from the vDSO without reading any hardware
+ * counter -- a few nanoseconds per call -- at the cost of a resolution of a kernel tick (1 to 4ms).
  *
  * NOTE: arm code gathered from
  * https://stackoverflow.com/questions/3247373/how-to-measure-program-execution-time-in-arm-cortex-a8-processor?answertab=active#tab-top
@@ -26,6 +35,8 @@ namespace MTL::time::TimeMeasurements {
     static inline unsigned long long getMonotonicRealTimeMS();
     static inline unsigned long long getMonotonicRealTimeUS();
     static inline unsigned long long getMonotonicRealTimeNS();
+    static inline unsigned long long getCoarseRealTimeMS();
+    static inline unsigned long long getCoarseMonotonicRealTimeMS();
 
     /** This is the fastest 'time' measurement function among all, but
       * it does not return the time directly -- it returns the cycle
@@ -39,13 +50,161 @@ namespace MTL::time::TimeMeasurements {
       *     - On x86, if your CPU has the 'constant_tsc' feature, the measurement is reliable
       *       among cores as well as it is reliable even when the CPU scales up or down
       *       (maybe the actual CPU_MAX_FREQUENCY is greater than advertised by the CPU
-      *       due to turbo); */
+      *       due to turbo);
+      *     - On AArch64, the generic timer's virtual count (CNTVCT_EL0) is used instead: it is always readable
+      *       from user space (no kernel module needed), 64 bits wide and ticks at a constant frequency -- usually
+      *       from tens of MHz to 1GHz, as told by CNTFRQ_EL0 (see 'TscClock::cyclesPerSecond()') -- so "cycles",
+      *       there, are timer ticks, coarser than the CPU's; */
     static inline uint64_t getProcessorCycleCount();
 
+    /** Serializing versions of 'getProcessorCycleCount()', for measuring short intervals, where the plain counter read
+      * may be reordered with the instructions being measured: 'Start' waits for all previous instructions to complete
+      * before reading the counter ('lfence; rdtsc' on x86, 'isb; mrs CNTVCT_EL0' on ARMv8), whereas 'End' reads it only
+      * after the measured instructions completed and keeps the following ones from starting before the read
+      * ('rdtscp; lfence' / 'isb; mrs CNTVCT_EL0; isb'). Both are compiler barriers as well.
+      * 'End' also tells the core it ran on -- from 'rdtscp's TSC_AUX, as set by Linux, or 'sched_getcpu()' elsewhere --
+      * so harnesses may discard samples where the thread migrated between 'Start' & 'End':
+      *     unsigned startCore, endCore;
+      *     uint64_t start   = getProcessorCycleCountStart(startCore);
+      *     ...
+      *     uint64_t elapsed = getProcessorCycleCountEnd(endCore) - start;
+      *     if (startCore != endCore) discard(elapsed); */
+    static inline uint64_t getProcessorCycleCountStart();
+    static inline uint64_t getProcessorCycleCountStart(unsigned& coreId);
+    static inline uint64_t getProcessorCycleCountEnd(unsigned& coreId);
+
     /** initialization for 'getProcessorCycleCount' needed by ARM */
     static inline unsigned armClockInit();
     static unsigned _armClockInit = armClockInit();
 
+    /** `std::chrono` clock (steady, with nanoseconds resolution) at the cost of 'getProcessorCycleCount()': its frequency
+      * is calibrated once per process -- read from CPUID leaf 0x15, when it enumerates the TSC / crystal ratio, or measured
+      * against CLOCK_MONOTONIC_RAW -- and cycles are converted to nanoseconds with a fixed point multiply & shift. Time is
+      * counted from the same origin as CLOCK_MONOTONIC, so both may be compared. Requires an invariant cycle counter, as
+      * given by x86's 'constant_tsc' feature or by ARMv8's generic timer -- whose frequency is read from CNTFRQ_EL0 */
+    struct TscClock {
+        typedef int64_t                                 rep;
+        typedef std::nano                               period;
+        typedef std::chrono::duration<rep, period>      duration;
+        typedef std::chrono::time_point<TscClock>       time_point;
+        static constexpr bool is_steady = true;
+
+        /** nanoseconds = ((cycles - cyclesOrigin) * multiplier) >> SHIFT + nsOrigin */
+        static constexpr unsigned SHIFT = 32;
+        /** how long to spend measuring the frequency, when CPUID doesn't tell it */
+        static constexpr uint64_t CALIBRATION_NS = 10'000'000;
+
+        struct Calibration {
+            uint64_t cyclesPerSecond;
+            uint64_t multiplier;
+            uint64_t cyclesOrigin;
+            uint64_t nsOrigin;
+        };
+
+        /** calibrated at load time -- see 'calibrationData' -- so no call pays for a guard check nor for the first one's
+          * calibration stall. Static initializers of other variables may use the clock only if defined after this header
+          * got included */
+        static inline const Calibration& calibration() {
+            return calibrationData;
+        }
+
+        static inline uint64_t cyclesPerSecond() {
+            return calibration().cyclesPerSecond;
+        }
+
+        /** converts a number of cycles -- as the difference between two 'getProcessorCycleCount()'s -- to nanoseconds */
+        static inline uint64_t cyclesToNs(uint64_t cycles) {
+            return mulShift(cycles, calibration().multiplier);
+        }
+
+        /** nanoseconds since CLOCK_MONOTONIC's origin */
+        static inline uint64_t nowNs() {
+            const Calibration& c = calibration();
+            return c.nsOrigin + mulShift(getProcessorCycleCount() - c.cyclesOrigin, c.multiplier);
+        }
+
+        static inline time_point now() noexcept {
+            return time_point(duration((rep)nowNs()));
+        }
+
+    private:
+
+        static const Calibration calibrationData;
+
+        /** (a * b) >> SHIFT, truncated to 64 bits -- through 32 bit halves where there is no 128 bit multiplication, as on
+          * 32 bit ARM: a*b = (ah*bh << 64) + ((ah*bl + al*bh) << 32) + al*bl, none of those partial products overflowing */
+        static inline uint64_t mulShift(uint64_t a, uint64_t b) {
+            static_assert(SHIFT == 32, "TscClock::mulShift(): the 32 bit halves split requires 'SHIFT' to be 32");
+#ifdef __SIZEOF_INT128__
+            return (uint64_t)( ((unsigned __int128)a * b) >> SHIFT );
+#else
+            uint64_t ah = a >> 32, al = a & 0xffffffffull;
+            uint64_t bh = b >> 32, bl = b & 0xffffffffull;
+            return ((ah*bh) << 32) + (ah*bl) + (al*bh) + ((al*bl) >> 32);
+#endif
+        }
+
+        static inline uint64_t clockNs(clockid_t clock) {
+            struct timespec now;
+            clock_gettime(clock, &now);
+            return (now.tv_sec*1000000000ull) + now.tv_nsec;
+        }
+
+        /** reads 'clock' along with the cycle count at (about) the same instant: the middle of the narrowest of a few tries */
+        static inline void sample(clockid_t clock, uint64_t& cycles, uint64_t& ns) {
+            uint64_t narrowest = UINT64_MAX;
+            for (int i=0; i<5; i++) {
+                uint64_t before = getProcessorCycleCount();
+                uint64_t clockNow = clockNs(clock);
+                uint64_t after  = getProcessorCycleCount();
+                if ((after - before) < narrowest) {
+                    narrowest = after - before;
+                    cycles    = before + (narrowest / 2);
+                    ns        = clockNow;
+                }
+            }
+        }
+
+        /** the counter's frequency, as told by the hardware -- 0 if not enumerated:
+          *   - x86: CPUID leaf 0x15: TSC frequency = crystal frequency * EBX / EAX
+          *   - AArch64: CNTFRQ_EL0, set by the firmware */
+        static inline uint64_t cpuidCyclesPerSecond() {
+#ifdef __x86_64
+            unsigned denominator, numerator, crystalHz, edx;
+            if ( (__get_cpuid_max(0, nullptr) >= 0x15) &&
+                 __get_cpuid_count(0x15, 0, &denominator, &numerator, &crystalHz, &edx) &&
+                 (denominator != 0) && (numerator != 0) && (crystalHz != 0) ) {
+                return ((uint64_t)crystalHz * numerator) / denominator;
+            }
+#elif MTL_ARCHITECTURE_ARM_64
+            uint64_t frequency;
+            __asm__ __volatile__ ("mrs %0, cntfrq_el0" : "=r" (frequency));
+            return frequency & 0xffffffff;      // the upper half is reserved
+#endif
+            return 0;
+        }
+
+        static inline Calibration calibrate() {
+            Calibration c;
+            c.cyclesPerSecond = cpuidCyclesPerSecond();
+            if (c.cyclesPerSecond == 0) {
+                uint64_t startCycles = 0, startNs = 0, endCycles = 0, endNs = 0;
+                sample(CLOCK_MONOTONIC_RAW, startCycles, startNs);
+                do {
+                    sample(CLOCK_MONOTONIC_RAW, endCycles, endNs);
+                } while ((endNs - startNs) < CALIBRATION_NS);
+                // in floating point, as 'cycles * 10^9' may not fit 64 bits if we were preempted for long
+                c.cyclesPerSecond = (uint64_t)( (double)(endCycles - startCycles) * 1e9 / (double)(endNs - startNs) );
+            }
+            c.multiplier = (1000000000ull << SHIFT) / c.cyclesPerSecond;     // 10^9 * 2^32 < 2^62
+            sample(CLOCK_MONOTONIC, c.cyclesOrigin, c.nsOrigin);
+            return c;
+        }
+    };
+    /** as '_armClockInit', initialized when the program loads -- once, being an inline variable, and after '_armClockInit',
+      * being defined after it on every translation unit */
+    inline const TscClock::Calibration TscClock::calibrationData = TscClock::calibrate();
+
 }
 
 
@@ -62,7 +221,12 @@ static inline unsigned TimeMeasurements::armClockInit() {
 
 #else
 
-	#if MTL_CPU_INSTR_ARMv7 || MTL_CPU_INSTR_ARMv8
+	#if MTL_ARCHITECTURE_ARM_64
+
+    // AArch64 reads the generic timer, which needs no initialization
+		return 0;
+
+	#elif MTL_CPU_INSTR_ARMv7 || MTL_CPU_INSTR_ARMv8
 
     // this code is needed to initialize both Raspberry Pi 2 & Raspberry Pi 3 before any measurements
     // can be made. It's execution is guranteed by the initialization of the static variable '_armClockInit'.
@@ -113,7 +277,14 @@ static inline uint64_t TimeMeasurements::getProcessorCycleCount() {
         return ((uint64_t)hi << 32) | lo;
 
 
-    // Raspberry Pi 2 & 3
+    // AArch64 (Raspberry Pi 3+ & other 64 bit ARMs): the generic timer's virtual count -- user space readable on Linux & FreeBSD
+    #elif MTL_ARCHITECTURE_ARM_64
+        uint64_t value;
+        __asm__ __volatile__ ("mrs %0, cntvct_el0" : "=r" (value));
+        return value;
+
+
+    // Raspberry Pi 2 & 3 (32 bit)
     #elif MTL_CPU_INSTR_ARMv7 || MTL_CPU_INSTR_ARMv8
     #ifdef MTL_OS_FreeBSD
 	// on FreeBSD, a fallback method is used, since the needed kernel modules are not available for that platform yet
@@ -141,33 +312,113 @@ static inline uint64_t TimeMeasurements::getProcessorCycleCount() {
     #endif
 }
 
+static inline uint64_t TimeMeasurements::getProcessorCycleCountStart() {
+
+    #ifdef __x86_64
+        unsigned lo, hi;
+        __asm__ __volatile__ ("lfence\n\trdtsc" : "=a" (lo), "=d" (hi) :: "memory");
+        return ((uint64_t)hi << 32) | lo;
 
-static struct timeval timeval_now;
-static struct timespec timespec_now;
+    #elif MTL_ARCHITECTURE_ARM_64
+        uint64_t value;
+        __asm__ __volatile__ ("isb\n\tmrs %0, cntvct_el0" : "=r" (value) :: "memory");
+        return value;
+
+    #else
+        // no serializing read is known for the other targets -- at least, keep the compiler from reordering around it
+        __asm__ __volatile__ ("" ::: "memory");
+        return getProcessorCycleCount();
+    #endif
+}
+
+static inline uint64_t TimeMeasurements::getProcessorCycleCountStart(unsigned& coreId) {
+    // the core is taken before the fenced read, so a migration in between is seen by 'getProcessorCycleCountEnd()'
+    #ifdef __x86_64
+        unsigned lo, hi, aux;
+        __asm__ __volatile__ ("rdtscp" : "=a" (lo), "=d" (hi), "=c" (aux));
+        coreId = aux & 0xfff;      // Linux sets TSC_AUX to (node << 12) | cpu
+    #else
+        coreId = (unsigned)sched_getcpu();
+    #endif
+    return getProcessorCycleCountStart();
+}
+
+static inline uint64_t TimeMeasurements::getProcessorCycleCountEnd(unsigned& coreId) {
+
+    #ifdef __x86_64
+        unsigned lo, hi, aux;
+        __asm__ __volatile__ ("rdtscp\n\tlfence" : "=a" (lo), "=d" (hi), "=c" (aux) :: "memory");
+        coreId = aux & 0xfff;      // Linux sets TSC_AUX to (node << 12) | cpu
+        return ((uint64_t)hi << 32) | lo;
+
+    #elif MTL_ARCHITECTURE_ARM_64
+        uint64_t value;
+        __asm__ __volatile__ ("isb\n\tmrs %0, cntvct_el0\n\tisb" : "=r" (value) :: "memory");
+        coreId = (unsigned)sched_getcpu();
+        return value;
+
+    #else
+        __asm__ __volatile__ ("" ::: "memory");
+        uint64_t value = getProcessorCycleCount();
+        __asm__ __volatile__ ("" ::: "memory");
+        coreId = (unsigned)sched_getcpu();
+        return value;
+    #endif
+}
+
+
+// the coarse clocks are Linux specific
+#ifdef CLOCK_REALTIME_COARSE
+    #define MTL_CLOCK_REALTIME_COARSE  CLOCK_REALTIME_COARSE
+    #define MTL_CLOCK_MONOTONIC_COARSE CLOCK_MONOTONIC_COARSE
+#else
+    #define MTL_CLOCK_REALTIME_COARSE  CLOCK_REALTIME
+    #define MTL_CLOCK_MONOTONIC_COARSE CLOCK_MONOTONIC
+#endif
 
 static inline unsigned long long TimeMeasurements::getRealTimeMS() {
-    gettimeofday(&timeval_now, NULL);
-    return (timeval_now.tv_sec*1000l) + (timeval_now.tv_usec/1000l);
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return (now.tv_sec*1000ll) + (now.tv_usec/1000ll);
 }
 
 static inline unsigned long long TimeMeasurements::getRealTimeUS() {
-    gettimeofday(&timeval_now, NULL);
-    return (timeval_now.tv_sec*1000000ll) + timeval_now.tv_usec;
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return (now.tv_sec*1000000ll) + now.tv_usec;
 }
 
 static inline unsigned long long TimeMeasurements::getMonotonicRealTimeMS() {
-    clock_gettime(CLOCK_MONOTONIC, &timespec_now);
-    return (timespec_now.tv_sec*1000ll) + (timespec_now.tv_nsec/1000000ll);
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec*1000ll) + (now.tv_nsec/1000000ll);
 }
 
 static inline unsigned long long TimeMeasurements::getMonotonicRealTimeUS() {
-    clock_gettime(CLOCK_MONOTONIC, &timespec_now);
-    return (timespec_now.tv_sec*1000000ll) + (timespec_now.tv_nsec/1000ll);
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec*1000000ll) + (now.tv_nsec/1000ll);
 }
 
 static inline unsigned long long TimeMeasurements::getMonotonicRealTimeNS() {
-    clock_gettime(CLOCK_MONOTONIC, &timespec_now);
-    return (timespec_now.tv_sec*1000000000ll) + timespec_now.tv_nsec;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec*1000000000ll) + now.tv_nsec;
 }
 
+static inline unsigned long long TimeMeasurements::getCoarseRealTimeMS() {
+    struct timespec now;
+    clock_gettime(MTL_CLOCK_REALTIME_COARSE, &now);
+    return (now.tv_sec*1000ll) + (now.tv_nsec/1000000ll);
+}
+
+static inline unsigned long long TimeMeasurements::getCoarseMonotonicRealTimeMS() {
+    struct timespec now;
+    clock_gettime(MTL_CLOCK_MONOTONIC_COARSE, &now);
+    return (now.tv_sec*1000ll) + (now.tv_nsec/1000000ll);
+}
+
+#undef MTL_CLOCK_REALTIME_COARSE
+#undef MTL_CLOCK_MONOTONIC_COARSE
+
 #endif //MTL_TimeMeasurements_hpp
@@ -4,6 +4,13 @@
 #include <thread>
 #include <cstring>
 #include <mutex>
+#include <vector>
+#include <deque>
+#include <system_error>
+#include <chrono>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <sched.h>
 
 #include "../../cpp/time/TimeMeasurements.hpp"
 using namespace MTL::time::TimeMeasurements;
@@ -52,6 +59,14 @@ void printInfo() {
 // check section
 ///////////////
 
+/** exits the spike if 'condition' doesn't hold */
+void check(bool condition, const char* what) {
+    if (!condition) {
+        std::cout << "--> Checking FAILED: " << what << ". Exiting..\n\n";
+        exit(1);
+    }
+}
+
 
 // spike methods
 ////////////////
@@ -117,6 +132,343 @@ void lockAndUnlock() {
                  "            try_lock: " <<             try_lock << "\n";
 }
 
+/** 'Futex' as a mutex: contending threads increment a plain counter, which must end up exact */
+void futexLockStress() {
+    constexpr unsigned nThreads   = 4;
+    constexpr unsigned nIncrements = 200'000;
+    Futex    futex;
+    unsigned counter = 0;
+
+    std::vector<std::thread> threads;
+    for (unsigned t=0; t<nThreads; t++) {
+        threads.emplace_back([&] {
+            for (unsigned i=0; i<nIncrements; i++) {
+                std::lock_guard<Futex> guard(futex);
+                counter++;
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    std::cout << "Futex lock stress: counter=" << counter << " (" << nThreads*nIncrements << " expected)\n";
+    check(counter == nThreads*nIncrements, "'Futex' let two threads in at once");
+}
+
+/** bounded queue guarded by a 'Futex', with 'FutexCondition's for "not empty" & "not full" -- consumers are stopped
+  * through 'notify_all()', exercising the requeue onto the 'Futex' */
+void futexConditionProducerConsumer() {
+    constexpr unsigned nProducers = 2;
+    constexpr unsigned nConsumers = 3;
+    constexpr unsigned nEvents    = 50'000;    // per producer
+    constexpr size_t   capacity   = 16;
+    Futex                futex;
+    FutexCondition       notEmpty, notFull;
+    std::deque<unsigned> queue;
+    bool                 stop = false;
+    uint64_t             consumedSum   = 0;
+    unsigned             consumedCount = 0;
+
+    std::vector<std::thread> consumers;
+    for (unsigned c=0; c<nConsumers; c++) {
+        consumers.emplace_back([&] {
+            futex.lock();
+            while (true) {
+                while (queue.empty() && !stop) {
+                    notEmpty.wait(futex);
+                }
+                if (queue.empty()) {
+                    break;      // stopped & drained
+                }
+                consumedSum += queue.front();
+                consumedCount++;
+                queue.pop_front();
+                notFull.notify_one();
+            }
+            futex.unlock();
+        });
+    }
+    std::vector<std::thread> producers;
+    for (unsigned p=0; p<nProducers; p++) {
+        producers.emplace_back([&] {
+            for (unsigned i=1; i<=nEvents; i++) {
+                futex.lock();
+                while (queue.size() >= capacity) {
+                    notFull.wait(futex);
+                }
+                queue.push_back(i);
+                futex.unlock();
+                notEmpty.notify_one();
+            }
+        });
+    }
+    for (std::thread& producer : producers) {
+        producer.join();
+    }
+    futex.lock();
+    stop = true;
+    futex.unlock();
+    notEmpty.notify_all();
+    for (std::thread& consumer : consumers) {
+        consumer.join();
+    }
+
+    uint64_t expectedSum = (uint64_t)nProducers * nEvents * (nEvents+1) / 2;
+    std::cout << "FutexCondition producer/consumer: consumed " << consumedCount << " events (" << nProducers*nEvents << " expected), "
+                 "sum=" << consumedSum << " (" << expectedSum << " expected)\n";
+    check( (consumedCount == nProducers*nEvents) && (consumedSum == expectedSum), "'FutexCondition' lost or duplicated events");
+}
+
+/** ping-pong through two auto reset 'FutexEvent's, then a manual reset one releasing a crowd of waiters */
+void futexEventProducerConsumer() {
+    constexpr unsigned nEvents  = 50'000;
+    constexpr unsigned nWaiters = 8;
+    FutexEvent<true> produced, consumed;
+    unsigned         slot     = 0;      // written by the producer, read by the consumer -- ordered by the events
+    uint64_t         sum      = 0;
+
+    std::thread consumer([&] {
+        for (unsigned i=1; i<=nEvents; i++) {
+            produced.wait();
+            sum += slot;
+            consumed.set();
+        }
+    });
+    for (unsigned i=1; i<=nEvents; i++) {
+        slot = i;
+        produced.set();
+        consumed.wait();
+    }
+    consumer.join();
+    uint64_t expectedSum = (uint64_t)nEvents * (nEvents+1) / 2;
+    std::cout << "FutexEvent<autoReset> ping-pong: sum=" << sum << " (" << expectedSum << " expected)\n";
+    check(sum == expectedSum, "auto reset 'FutexEvent' lost or duplicated a signal");
+    check(!produced.try_wait() && !consumed.try_wait(), "auto reset 'FutexEvent' was not reset by its waiter");
+
+    FutexEvent<false>     start;
+    std::atomic<unsigned> released = ATOMIC_VAR_INIT(0);
+    std::vector<std::thread> waiters;
+    for (unsigned w=0; w<nWaiters; w++) {
+        waiters.emplace_back([&] {
+            start.wait();
+            released.fetch_add(1, std::memory_order_relaxed);
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    check(released == 0, "manual reset 'FutexEvent' released waiters before being set");
+    start.set();
+    for (std::thread& waiter : waiters) {
+        waiter.join();
+    }
+    std::cout << "FutexEvent<manualReset>: released " << released << " waiters (" << nWaiters << " expected)\n";
+    check( (released == nWaiters) && start.try_wait(), "manual reset 'FutexEvent' didn't release all waiters or didn't stay set");
+    start.reset();
+    check(!start.try_wait(), "manual reset 'FutexEvent' didn't reset");
+}
+
+/** a consumer sleeping on several futexes at once, through 'waitAnyFn', is woken by producers signaling each one of them
+  * through 'FutexAdapter::wakeAny()' -- and times out when none is */
+template<typename _WaitAnyFn>
+void waitAnyAndWakeAny(const char* pathName, _WaitAnyFn waitAnyFn) {
+    constexpr unsigned nFutexes = 4;
+    constexpr unsigned nRounds  = 2'000;
+    std::atomic<int32_t> words[nFutexes];
+    for (std::atomic<int32_t>& word : words) {
+        word.store(0, std::memory_order_relaxed);
+    }
+    std::atomic<int32_t> signaled = ATOMIC_VAR_INIT(-1);     // which futex the producer changed on this round
+    std::atomic<int32_t> consumed = ATOMIC_VAR_INIT(0);      // rounds the consumer finished
+    unsigned mismatches = 0;
+
+    std::thread consumer([&] {
+        for (unsigned round=0; round<nRounds; round++) {
+            FutexAdapter::WaitAnyEntry entries[nFutexes];
+            for (unsigned i=0; i<nFutexes; i++) {
+                // futexes before this round's one were already bumped on this lap
+                entries[i] = {&words[i], (int32_t)(round / nFutexes) + (i < round % nFutexes ? 1 : 0)};
+            }
+            int index;
+            do {
+                index = waitAnyFn(entries, nFutexes, nullptr);
+            } while ( (index == -1) && (errno == EINTR) );
+            if (index != signaled.load(std::memory_order_acquire)) {
+                mismatches++;
+            }
+            consumed.store(round+1, std::memory_order_release);
+            FutexAdapter::wake(consumed, 1);
+        }
+    });
+    for (unsigned round=0; round<nRounds; round++) {
+        unsigned index = round % nFutexes;
+        signaled.store(index, std::memory_order_relaxed);
+        words[index].fetch_add(1, std::memory_order_release);
+        FutexAdapter::wakeAny(words[index], 1);
+        int32_t finished;
+        while ( (finished = consumed.load(std::memory_order_acquire)) != (int32_t)round+1 ) {
+            FutexAdapter::wait(consumed, finished);
+        }
+    }
+    consumer.join();
+
+    // nothing signaled: must time out
+    FutexAdapter::WaitAnyEntry entries[nFutexes];
+    for (unsigned i=0; i<nFutexes; i++) {
+        entries[i] = {&words[i], words[i].load(std::memory_order_relaxed)};
+    }
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_nsec += 20'000'000;
+    if (deadline.tv_nsec >= 1'000'000'000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1'000'000'000;
+    }
+    int timedOut;
+    do {
+        timedOut = waitAnyFn(entries, nFutexes, &deadline);
+    } while ( (timedOut == -1) && (errno == EINTR) );
+    int timedOutErrno = errno;
+
+    std::cout << "waitAny() / wakeAny() through " << pathName << ": " << nRounds << " rounds, " << mismatches << " wrong indexes; "
+                 "timed out wait returned " << timedOut << " (" << strerror(timedOutErrno) << ")\n";
+    check(mismatches == 0, "'waitAny()' returned the index of a futex not signaled");
+    check( (timedOut == -1) && (timedOutErrno == ETIMEDOUT), "'waitAny()' didn't time out with nothing signaled");
+}
+
+/** 'waitAny()' on both the 'futex_waitv()' path -- if the kernel has it -- and the shared wake word fallback */
+void waitAnyAndWakeAny() {
+    if (FutexAdapter::isWaitvAvailable()) {
+        waitAnyAndWakeAny("futex_waitv()", FutexAdapter::waitAny);
+    } else {
+        std::cout << "waitAny() / wakeAny() through futex_waitv(): NOT AVAILABLE on this kernel\n";
+    }
+    waitAnyAndWakeAny("the shared wake word fallback", FutexAdapter::waitAnyFallback);
+}
+
+/** 'PIFutex' contended by several threads, taken over from a thread which exited holding it and refusing to relock */
+void piFutexContentionAndErrors() {
+    constexpr unsigned nThreads    = 4;
+    constexpr unsigned nIncrements = 50'000;
+    PIFutex  piFutex;
+    unsigned counter = 0;
+
+    std::vector<std::thread> threads;
+    for (unsigned t=0; t<nThreads; t++) {
+        threads.emplace_back([&] {
+            for (unsigned i=0; i<nIncrements; i++) {
+                std::lock_guard<PIFutex> guard(piFutex);
+                counter++;
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    std::cout << "PIFutex lock stress: counter=" << counter << " (" << nThreads*nIncrements << " expected)\n";
+    check(counter == nThreads*nIncrements, "'PIFutex' let two threads in at once");
+
+    std::thread([&] { piFutex.lock(); }).join();     // exits holding it
+    piFutex.lock();
+    bool tookOver = piFutex.futexWord.load() == FutexAdapter::threadId();
+    bool deadlockReported = false;
+    try {
+        piFutex.lock();
+    } catch (const std::system_error& e) {
+        deadlockReported = e.code().value() == EDEADLK;
+    }
+    piFutex.unlock();
+    std::cout << "PIFutex error handling: " << (tookOver ? "took over from a dead owner" : "DIDN'T take over from a dead owner") << ", "
+              << (deadlockReported ? "EDEADLK thrown on relock" : "NO EDEADLK thrown on relock") << "\n";
+    check(tookOver, "'PIFutex' wasn't taken over from its dead owner");
+    check(deadlockReported, "'PIFutex' didn't throw EDEADLK when relocked by its owner");
+}
+
+/** a child process dies (SIGKILL) holding a 'RobustFutex' placed on shared memory: the parent must take it over, with
+  * 'ownerDied()' telling so -- first while the child is a zombie, then after it is reaped */
+void robustFutexOwnerDied() {
+    struct Shared {
+        RobustFutex          futex;
+        std::atomic<int32_t> childLocked = 0;
+    };
+    void* memory = mmap(nullptr, sizeof(Shared), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    check(memory != MAP_FAILED, "couldn't mmap the shared memory");
+    Shared* shared = new (memory) Shared();
+
+    for (bool reapFirst : {false, true}) {
+        shared->childLocked.store(0);
+        pid_t child = fork();
+        if (child == 0) {
+            shared->futex.lock();
+            shared->childLocked.store(1, std::memory_order_release);
+            FutexAdapter::wake<true>(shared->childLocked, 1);
+            for (;;) pause();
+        }
+        check(child > 0, "couldn't fork");
+        while (shared->childLocked.load(std::memory_order_acquire) == 0) {
+            FutexAdapter::wait<true>(shared->childLocked, 0);
+        }
+        check(!shared->futex.try_lock(), "'RobustFutex' was taken by two processes at once");
+        kill(child, SIGKILL);
+        if (reapFirst) {
+            waitpid(child, nullptr, 0);
+        }
+        auto start = std::chrono::steady_clock::now();
+        shared->futex.lock();
+        long long tookOverMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        bool ownerDied = shared->futex.ownerDied();
+        shared->futex.unlock();
+        if (!reapFirst) {
+            waitpid(child, nullptr, 0);
+        }
+        bool relockedClean = shared->futex.try_lock() && !shared->futex.ownerDied();
+        shared->futex.unlock();
+        std::cout << "RobustFutex owner killed (" << (reapFirst ? "reaped" : "zombie") << "): taken over in " << tookOverMs << "ms, "
+                     "ownerDied()=" << ownerDied << "; next lock ownerDied()=" << !relockedClean << "\n";
+        check(ownerDied, "'RobustFutex::ownerDied()' didn't report the killed owner");
+        check(relockedClean, "'RobustFutex::ownerDied()' was still reported on the next, regular, lock");
+    }
+    munmap(memory, sizeof(Shared));
+}
+
+/** a waiter on another PID namespace -- which can't see the owner's tid -- must not take a 'RobustFutex' over from its
+  * live owner. Requires CAP_SYS_ADMIN (to create the namespace), being skipped otherwise */
+void robustFutexOtherPidNamespace() {
+    struct Shared {
+        RobustFutex          futex;
+        std::atomic<int32_t> outcome = 0;     // 1: waiter timed out; 2: waiter took the lock; 3: no namespace
+    };
+    void* memory = mmap(nullptr, sizeof(Shared), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    check(memory != MAP_FAILED, "couldn't mmap the shared memory");
+    Shared* shared = new (memory) Shared();
+
+    shared->futex.lock();
+    pid_t child = fork();
+    if (child == 0) {
+        if (unshare(CLONE_NEWPID) == -1) {
+            shared->outcome.store(3);
+            _exit(0);
+        }
+        pid_t waiter = fork();      // the first process on the new namespace
+        if (waiter == 0) {
+            bool locked = shared->futex.try_lock_for(std::chrono::milliseconds(300));
+            shared->outcome.store(locked ? 2 : 1);
+            _exit(0);
+        }
+        waitpid(waiter, nullptr, 0);
+        _exit(0);
+    }
+    check(child > 0, "couldn't fork");
+    waitpid(child, nullptr, 0);
+    shared->futex.unlock();
+    int32_t outcome = shared->outcome.load();
+    munmap(memory, sizeof(Shared));
+    if (outcome == 3) {
+        std::cout << "RobustFutex waiter on another PID namespace: SKIPPED (couldn't create a PID namespace)\n";
+        return;
+    }
+    std::cout << "RobustFutex waiter on another PID namespace: " << (outcome == 1 ? "timed out" : "TOOK THE LOCK OVER") << " from a live owner\n";
+    check(outcome == 1, "'RobustFutex' was taken over, from another PID namespace, while its owner was alive");
+}
+
 
 int main(void) {
 
@@ -129,6 +481,13 @@ int main(void) {
 
     waitAndResume();
     lockAndUnlock();
+    futexLockStress();
+    futexConditionProducerConsumer();
+    futexEventProducerConsumer();
+    waitAnyAndWakeAny();
+    piFutexContentionAndErrors();
+    robustFutexOwnerDied();
+    robustFutexOtherPidNamespace();
 
     return 0;
 }
@@ -4,12 +4,21 @@
 #include <thread>
 #include <cstring>
 #include <mutex>
+#include <vector>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/wait.h>
 
 #include "../../cpp/time/TimeMeasurements.hpp"
+#include "../../cpp/time/LatencyRecorder.hpp"
 using namespace MTL::time::TimeMeasurements;
 
 #include "../../cpp/thread/FutexAdapter.hpp"
 #include "../../cpp/thread/SpinLock.hpp"    // also provides cpu_relax() macro, which uses the x86's "pause" or arm's "yield" instructions
+#include "../../cpp/thread/SharedSpinLock.hpp"
+#include "../../cpp/thread/FlatCombiner.hpp"
+#include "../../cpp/thread/SeqLock.hpp"
+#include "../../cpp/thread/DynamicSpinLock.hpp"
 using namespace MTL::thread;
 
 // compile & run with clear; echo -en "\n\n###############\n\n"; toStop="chrome vscode visual-studio-code subl3 java"; for p in $toStop; do pkill -stop -f "$p"; done; sudo sync; g++ -std=c++17 -O3 -mcpu=native -march=native -mtune=native -pthread -I../../external/EABase/include/Common/ SpinLockSpikes.cpp -o SpinLockSpikes && sudo sync && sleep 2 && sudo time nice -n -20 ./SpinLockSpikes; for p in $toStop; do pkill -cont -f "$p"; done
@@ -181,6 +190,789 @@ void check(unsigned& nEvents) {
     }
 }
 
+/** checks 'SpinLock's histograms & sharded metrics (the last template parameters) count every lock & unlock made by contending threads */
+void checkSpinLockHistogramsAndShardedMetrics() {
+    constexpr unsigned nThreads = 4;
+    constexpr unsigned nLocks   = 100'000;
+    static SpinLock<ESpinMethod::Yield, ELockSpecializations::RMWLight, /*_opMetrics*/true, !(uint64_t)0, nullptr, !(uint64_t)0,
+                    false, nullptr, nullptr, nullptr, nullptr, /*_histograms*/true, /*_shardedMetrics*/true> histogramsLock;
+    static unsigned counter;
+    counter = 0;
+
+    std::cout << "\nChecking 'SpinLock' histograms & sharded metrics with " << nThreads << " threads... " << std::flush;
+    std::vector<std::thread> threads;
+    for (unsigned t=0; t<nThreads; t++) {
+        threads.emplace_back([] {
+            for (unsigned i=0; i<nLocks; i++) {
+                std::lock_guard<decltype(histogramsLock)> guard(histogramsLock);
+                counter++;
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    SpinLockHistogramsSnapshot snapshot = histogramsLock.histogramsSnapshot();
+    SpinLockMetricsSnapshot    metrics  = histogramsLock.metricsSnapshot();
+    if ( (counter != nThreads*nLocks) || (snapshot.waitCycles.count != nThreads*nLocks) || (snapshot.holdCycles.count != nThreads*nLocks) ||
+         (metrics.lockCallsCount != nThreads*nLocks) || (metrics.unlockCallsCount != nThreads*nLocks) ) {
+        std::cout << "FAILED: counter=" << counter << ", waitCycles.count=" << snapshot.waitCycles.count << ", holdCycles.count="
+                  << snapshot.holdCycles.count << ", lockCallsCount=" << metrics.lockCallsCount << ", unlockCallsCount="
+                  << metrics.unlockCallsCount << " -- " << nThreads*nLocks << " expected. Exiting..\n\n";
+        exit(1);
+    }
+    std::cout << "OK (waitCycles={p50<" << snapshot.waitCycles.p50 << ", p999<" << snapshot.waitCycles.p999 << "}, "
+                 "holdCycles={p50<" << snapshot.holdCycles.p50 << ", p999<" << snapshot.holdCycles.p999 << "})\n";
+}
+
+/** records known values into a 'LatencyRecorder' from several threads -- snapshotting it meanwhile -- and checks the merged
+  * counts & percentiles, plus real 'recordSince()' measurements converted through 'TscClock' */
+void checkLatencyRecorder() {
+    constexpr unsigned nThreads = 4;
+    constexpr unsigned nValues  = 100'000;     // each thread records 1..nValues
+    static LatencyRecorder<> recorder;
+    static std::atomic<bool> recording;
+    recording = true;
+
+    std::cout << "\nChecking 'LatencyRecorder' with " << nThreads << " threads... " << std::flush;
+    std::vector<std::thread> threads;
+    for (unsigned t=0; t<nThreads; t++) {
+        threads.emplace_back([] {
+            for (uint64_t value=1; value<=nValues; value++) {
+                recorder.record(value);
+            }
+        });
+    }
+    // snapshots taken while recording must never go backwards
+    bool monotonic = true;
+    uint64_t previousCount = 0;
+    std::thread snapshotter([&] {
+        while (recording) {
+            uint64_t count = recorder.snapshot().count;
+            monotonic = monotonic && (count >= previousCount);
+            previousCount = count;
+            std::this_thread::yield();
+        }
+    });
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    recording = false;
+    snapshotter.join();
+
+    LatencyRecorder<>::Snapshot snapshot = recorder.snapshot();
+    uint64_t p50  = snapshot.valueAtPerMille(500);
+    uint64_t p999 = snapshot.valueAtPerMille(999);
+    // buckets are exact to 1/32 -- and percentiles are reported as their bucket's highest value
+    bool percentilesOK = (p50  >= nValues/2)       && (p50  <= nValues/2       + nValues/2/32 + 1) &&
+                         (p999 >= nValues*999/1000) && (p999 <= nValues*999/1000 + nValues/32   + 1);
+    if ( (snapshot.count != nThreads*nValues) || (snapshot.min() != 1) || (snapshot.max() < nValues) || !percentilesOK || !monotonic ) {
+        std::cout << "FAILED: count=" << snapshot.count << " (" << nThreads*nValues << " expected), min=" << snapshot.min()
+                  << ", max=" << snapshot.max() << ", p50=" << p50 << ", p999=" << p999 << ", monotonic snapshots=" << monotonic
+                  << ". Exiting..\n\n";
+        exit(1);
+    }
+
+    // real measurements, on an interval given by subtracting snapshots
+    LatencyRecorder<>::Snapshot before = recorder.snapshot();
+    for (unsigned i=0; i<1000; i++) {
+        uint64_t start = getProcessorCycleCount();
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        recorder.recordSince(start);
+    }
+    LatencyRecorder<>::Snapshot interval = recorder.snapshot();
+    interval -= before;
+    if (interval.count != 1000) {
+        std::cout << "FAILED: subtracted snapshots counted " << interval.count << " samples (1000 expected). Exiting..\n\n";
+        exit(1);
+    }
+    std::cout << "OK (p50=" << p50 << ", p999=" << p999 << "; fence latency: p50<" << interval.valueAtPerMille(500) << " cycles ("
+              << TscClock::cyclesToNs(interval.valueAtPerMille(500)) << "ns), p999<" << interval.valueAtPerMille(999) << " cycles)\n";
+}
+
+/** a child process dies (SIGKILL) holding a 'RobustFutex' 'SpinLock' with no hard lock fallback -- whose spinning must
+  * still end up sleeping on the futex, where the dead owner is detected and 'ownerDied()' reported */
+void checkRobustFutexSpinLockOwnerDied() {
+    typedef SpinLock<ESpinMethod::Yield, ELockSpecializations::RobustFutex, /*_opMetrics*/true, !(uint64_t)0, nullptr, !(uint64_t)0> RobustLock;
+    struct Shared {
+        RobustLock           lock;
+        std::atomic<int32_t> childLocked = 0;
+    };
+
+    std::cout << "\nChecking 'SpinLock<..., NoHardLockFallback, RobustFutex>' taken over from a killed process... " << std::flush;
+    void* memory = mmap(nullptr, sizeof(Shared), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        std::cout << "FAILED: couldn't mmap the shared memory. Exiting..\n\n";
+        exit(1);
+    }
+    Shared* shared = new (memory) Shared();
+    pid_t child = fork();
+    if (child == 0) {
+        shared->lock.lock();
+        shared->childLocked.store(1, std::memory_order_release);
+        for (;;) pause();
+    }
+    while (shared->childLocked.load(std::memory_order_acquire) == 0) {
+        std::this_thread::yield();
+    }
+    kill(child, SIGKILL);
+    waitpid(child, nullptr, 0);
+    shared->lock.lock();
+    bool ownerDied = shared->lock.ownerDied();
+    shared->lock.unlock();
+    munmap(memory, sizeof(Shared));
+    if (!ownerDied) {
+        std::cout << "FAILED: 'ownerDied()' didn't report the killed owner. Exiting..\n\n";
+        exit(1);
+    }
+    std::cout << "OK\n";
+}
+
+/** 'Elided' & 'ElidedFutex' stressed by threads locking & unlocking them (from the same thread) -- each taking two of them,
+  * nested, so '_unlock()' must tell an elided lock from one taken through its fallback. With no RTM, this is all on the
+  * fallback path */
+template <typename _Lock>
+void checkElidedLock(const char* lockName) {
+    constexpr unsigned nThreads = 4;
+    constexpr unsigned nLocks   = 100'000;
+    static _Lock    outerLock, innerLock;
+    static uint64_t outerCounter, innerCounter;
+    outerCounter = innerCounter = 0;
+    std::vector<std::thread> threads;
+    for (unsigned t=0; t<nThreads; t++) {
+        threads.emplace_back([t] {
+            for (unsigned i=0; i<nLocks; i++) {
+                if ((i+t) % 2 == 0) {
+                    std::lock_guard<_Lock> outerGuard(outerLock);
+                    outerCounter++;
+                    std::lock_guard<_Lock> innerGuard(innerLock);
+                    innerCounter++;
+                } else {
+                    while (!innerLock.try_lock()) {
+                        std::this_thread::yield();
+                    }
+                    innerCounter++;
+                    innerLock.unlock();
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    if ( (outerCounter != nThreads*nLocks/2) || (innerCounter != nThreads*nLocks) ) {
+        std::cout << "FAILED: '" << lockName << "' counters=" << outerCounter << "/" << innerCounter
+                  << " (" << nThreads*nLocks/2 << "/" << nThreads*nLocks << " expected). Exiting..\n\n";
+        exit(1);
+    }
+}
+
+void checkElidedLocks() {
+    std::cout << "\nChecking 'Elided' locks with " << (isRTMAvailable() ? "RTM" : "no RTM -- so on the fallback path") << "... " << std::flush;
+    checkElidedLock<SpinLock<ESpinMethod::Yield, ELockSpecializations::Elided>>("Elided");
+    checkElidedLock<SpinLock<ESpinMethod::Yield, ELockSpecializations::ElidedFutex>>("ElidedFutex");
+    checkElidedLock<SpinLock<ESpinMethod::Yield, ELockSpecializations::ElidedFutex, false, !(uint64_t)0, nullptr, 10'000>>("ElidedFutex with hard lock fallback");
+    std::cout << "OK\n";
+}
+
+/** NUMA aware cohort locks stressed with 'lock()' & 'try_lock()' -- both straight and through 'SpinLock's controlled spin,
+  * which must register its waiters for the global lock to be handed over within a node -- checking that no two threads
+  * are ever inside at once */
+template <typename _Lock>
+void checkCohortLock(const char* lockName) {
+    constexpr unsigned nThreads = 4;
+    constexpr unsigned nLocks   = 50'000;
+    static _Lock                 lock;
+    static uint64_t              counter;
+    static std::atomic<unsigned> inside;
+    static std::atomic<unsigned> overlaps;
+    counter  = 0;
+    inside   = 0;
+    overlaps = 0;
+    std::vector<std::thread> threads;
+    for (unsigned t=0; t<nThreads; t++) {
+        threads.emplace_back([t] {
+            for (unsigned i=0; i<nLocks; i++) {
+                if ((i+t) % 4 == 0) {
+                    while (!lock.try_lock()) {
+                        std::this_thread::yield();
+                    }
+                } else {
+                    lock.lock();
+                }
+                if (inside.fetch_add(1, std::memory_order_relaxed) != 0) {
+                    overlaps.fetch_add(1, std::memory_order_relaxed);
+                }
+                counter++;
+                inside.fetch_sub(1, std::memory_order_relaxed);
+                lock.unlock();
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    if ( (counter != nThreads*nLocks) || (overlaps != 0) ) {
+        std::cout << "FAILED: '" << lockName << "' counter=" << counter << " (" << nThreads*nLocks << " expected), "
+                  << overlaps << " overlapping critical sections. Exiting..\n\n";
+        exit(1);
+    }
+}
+
+void checkCohortLocks() {
+    std::cout << "\nChecking 'Cohort' locks on " << NumaTopology::get().nNodes << " NUMA node(s)... " << std::flush;
+    checkCohortLock<SpinLock<ESpinMethod::Yield, ELockSpecializations::Cohort>>("Cohort");
+    checkCohortLock<SpinLock<ESpinMethod::Yield, ELockSpecializations::CohortOuroboros>>("CohortOuroboros");
+    checkCohortLock<SpinLock<ESpinMethod::Yield, ELockSpecializations::Cohort, /*_opMetrics*/true>>("Cohort with metrics");
+    checkCohortLock<SpinLock<ESpinMethod::Yield, ELockSpecializations::CohortOuroboros, false, !(uint64_t)0, nullptr, 10'000>>("CohortOuroboros with hard lock fallback");
+    std::cout << "OK\n";
+}
+
+/** 'try_lock_for()' & 'try_lock_until()' on '_Lock': giving up on a lock held for longer than the timeout, acquiring one
+  * released before it and not waiting at all for deadlines already past -- the lock being taken & released by another thread */
+template <typename _Lock>
+void checkTimedLock(const char* lockName) {
+    using namespace std::chrono;
+    static _Lock             lock;
+    static std::atomic<bool> held;
+    static std::atomic<bool> release;
+    auto fail = [lockName](const char* what, milliseconds elapsed) {
+        std::cout << "FAILED: '" << lockName << "' " << what << " (after " << elapsed.count() << "ms). Exiting..\n\n";
+        exit(1);
+    };
+    auto elapsedSince = [](steady_clock::time_point start) {
+        return duration_cast<milliseconds>(steady_clock::now() - start);
+    };
+    // holds the lock until 'release' -- or for 'holdFor', if given
+    auto holder = [](milliseconds holdFor) {
+        held    = false;
+        release = false;
+        return std::thread([holdFor] {
+            lock.lock();
+            held = true;
+            steady_clock::time_point until = steady_clock::now() + holdFor;
+            while ( !release && ((holdFor.count() == 0) || (steady_clock::now() < until)) ) {
+                std::this_thread::sleep_for(milliseconds(1));
+            }
+            lock.unlock();
+        });
+    };
+
+    // past deadlines on a free lock: like 'try_lock()'
+    steady_clock::time_point start = steady_clock::now();
+    if (!lock.try_lock_until(steady_clock::now() - seconds(1))) {
+        fail("didn't take a free lock with a past deadline", elapsedSince(start));
+    }
+    lock.unlock();
+
+    // timeout on a held lock
+    std::thread thread = holder(milliseconds(0));
+    while (!held) std::this_thread::yield();
+    start = steady_clock::now();
+    if (lock.try_lock_for(milliseconds(50))) {
+        fail("was taken while held by another thread", elapsedSince(start));
+    }
+    milliseconds elapsed = elapsedSince(start);
+    if ( (elapsed < milliseconds(50)) || (elapsed > milliseconds(1000)) ) {
+        fail("didn't time out after 50ms", elapsed);
+    }
+    // the same, with a deadline on another clock
+    start = steady_clock::now();
+    if (lock.try_lock_until(system_clock::now() + milliseconds(50))) {
+        fail("was taken while held by another thread", elapsedSince(start));
+    }
+    elapsed = elapsedSince(start);
+    if ( (elapsed < milliseconds(40)) || (elapsed > milliseconds(1000)) ) {
+        fail("didn't time out after 50ms of 'system_clock'", elapsed);
+    }
+    // past deadline on a held lock: no waiting at all
+    start = steady_clock::now();
+    if (lock.try_lock_until(steady_clock::now() - seconds(1))) {
+        fail("was taken while held by another thread", elapsedSince(start));
+    }
+    if ( (elapsed = elapsedSince(start)) > milliseconds(20) ) {
+        fail("waited on a past deadline", elapsed);
+    }
+    release = true;
+    thread.join();
+
+    // acquisition on release, well before the deadline
+    thread = holder(milliseconds(30));
+    while (!held) std::this_thread::yield();
+    start = steady_clock::now();
+    if (!lock.try_lock_for(seconds(5))) {
+        fail("wasn't taken once released", elapsedSince(start));
+    }
+    if ( (elapsed = elapsedSince(start)) > milliseconds(1000) ) {
+        fail("took too long to be taken once released", elapsed);
+    }
+    lock.unlock();
+    thread.join();
+}
+
+void checkTimedLocks() {
+    std::cout << "\nChecking 'try_lock_for()' & 'try_lock_until()'... " << std::flush;
+    checkTimedLock<Futex>("Futex");
+    checkTimedLock<RobustFutex>("RobustFutex");
+    checkTimedLock<SpinLock<ESpinMethod::Yield, ELockSpecializations::Futex>>("SpinLock<Futex> (parking at once)");
+    checkTimedLock<SpinLock<ESpinMethod::Yield, ELockSpecializations::Futex, false, !(uint64_t)0, nullptr, 100'000>>("SpinLock<Futex> (parking after 100k cycles)");
+    checkTimedLock<SpinLock<ESpinMethod::Yield, ELockSpecializations::Futex, false, !(uint64_t)0, nullptr, SpinLockAdaptiveHardLockFallback>>("SpinLock<Futex> (adaptive parking)");
+    checkTimedLock<SpinLock<ESpinMethod::Yield, ELockSpecializations::RobustFutex>>("SpinLock<RobustFutex>");
+    checkTimedLock<SpinLock<ESpinMethod::Yield, ELockSpecializations::Mutex>>("SpinLock<Mutex>");
+    checkTimedLock<SpinLock<ESpinMethod::Yield, ELockSpecializations::RMWLight>>("SpinLock<RMWLight> (spinning)");
+    checkTimedLock<SpinLock<ESpinMethod::WaitOnAddress, ELockSpecializations::Ticket, /*_opMetrics*/true>>("SpinLock<Ticket> (spinning, with metrics)");
+    std::cout << "OK\n";
+}
+
+/** the lock order validator: taking two named locks as A --> B and then as B --> A must be reported exactly once, however many
+  * times it happens -- and acquisitions released by other threads must not be remembered after their acquirers exit */
+void checkLockOrderValidator() {
+    std::cout << "\nChecking the lock order validator... " << std::flush;
+    if constexpr (!SpinLockLockOrderValidation) {
+        std::cout << "skipped (NDEBUG build)\n";
+        return;
+    }
+    static const char lockAName[] = "validated lock A";
+    static const char lockBName[] = "validated lock B";
+    static const char lockCName[] = "validated lock C";
+    static SpinLock<ESpinMethod::Yield, ELockSpecializations::RMWLight, false, 1'000'000'000, lockAName> lockA;
+    static SpinLock<ESpinMethod::Yield, ELockSpecializations::RMWLight, false, 1'000'000'000, lockBName> lockB;
+    static SpinLock<ESpinMethod::Yield, ELockSpecializations::RMWLight, false, 1'000'000'000, lockCName> lockC;
+
+    stringstream    reports;
+    std::streambuf* cerrBuffer = std::cerr.rdbuf(reports.rdbuf());
+    for (unsigned i=0; i<3; i++) {
+        std::thread([] {
+            std::lock_guard<decltype(lockA)> guardA(lockA);
+            std::lock_guard<decltype(lockB)> guardB(lockB);
+        }).join();
+        std::thread([] {
+            std::lock_guard<decltype(lockB)> guardB(lockB);
+            std::lock_guard<decltype(lockA)> guardA(lockA);
+        }).join();
+    }
+    std::cerr.rdbuf(cerrBuffer);
+    string   output   = reports.str();
+    unsigned nReports = 0;
+    for (size_t position = output.find("possible deadlock"); position != string::npos; position = output.find("possible deadlock", position+1)) {
+        nReports++;
+    }
+    if ( (nReports != 1) || (output.find(lockAName) == string::npos) || (output.find(lockBName) == string::npos) ) {
+        std::cout << "FAILED: expected exactly 1 inversion report, got " << nReports << ":\n" << output << "Exiting..\n\n";
+        exit(1);
+    }
+
+    // released by another thread after its acquirer exited -- and before it did, with no chance of pruning it
+    std::thread([] { lockC.lock(); }).join();
+    lockC.unlock();
+    static std::atomic<bool> acquiredByThread, releasedByMain;
+    acquiredByThread = releasedByMain = false;
+    std::thread acquirer([] {
+        lockC.lock();
+        acquiredByThread = true;
+        while (!releasedByMain) std::this_thread::yield();
+    });
+    while (!acquiredByThread) std::this_thread::yield();
+    lockC.unlock();
+    releasedByMain = true;
+    acquirer.join();
+    SpinLockLockOrderValidator::Graph& g = SpinLockLockOrderValidator::graph();
+    std::lock_guard<std::mutex> guard(g.mutex);
+    if ( (g.releasedByOthers.size() != 0) || (g.heldByExited.size() != 0) || (SpinLockLockOrderValidator::nReleasedByOthers != 0) ) {
+        std::cout << "FAILED: acquisitions of exited threads are still remembered: releasedByOthers=" << g.releasedByOthers.size()
+                  << ", heldByExited=" << g.heldByExited.size() << ". Exiting..\n\n";
+        exit(1);
+    }
+    std::cout << "OK\n";
+}
+
+/** 'DynamicSpinLock': configuration strings surviving the 'parseConfiguration()' --> 'configuration()' round trip for every
+  * lock strategy & spin method, operations dispatched to the chosen specialization keeping mutual exclusion, and invalid
+  * configurations -- including 'SpinLock's sentinel cycle counts -- being refused */
+void checkDynamicSpinLock() {
+    std::cout << "\nChecking 'DynamicSpinLock' configurations & dispatching... " << std::flush;
+    const char* lockStrategyNames[] = {"Mutex", "Futex", "AtomicFlag", "RMWLight", "Ouroboros", "Ticket", "MCS", "CLH",
+                                       "Elided", "ElidedFutex", "Cohort", "CohortOuroboros", "PIFutex"};
+    const char* spinMethodNames[]   = {"NoOp", "CPURelax", "CPURelax10", "Yield", "ExponentialBackoff", "WaitOnAddress"};
+    for (const char* lockStrategyName : lockStrategyNames) {
+        for (const char* spinMethodName : spinMethodNames) {
+            for (const char* fallback : {"", ":0", ":2", ":100000"}) {
+                string configuration = string(lockStrategyName) + ":" + spinMethodName + fallback;
+                DynamicSpinLock lock(configuration);
+                if (lock.configuration() != configuration) {
+                    std::cout << "FAILED: '" << configuration << "' came back as '" << lock.configuration() << "'. Exiting..\n\n";
+                    exit(1);
+                }
+            }
+        }
+    }
+    if (DynamicSpinLock("Futex").configuration() != "Futex:CPURelax") {
+        std::cout << "FAILED: 'Futex' didn't default to the 'CPURelax' spin method. Exiting..\n\n";
+        exit(1);
+    }
+
+    for (const char* configuration : {"Futex:Yield", "RMWLight:Yield:10000", "MCS:Yield", "Cohort:Yield:0", "PIFutex:Yield:100000"}) {
+        static DynamicSpinLock* lock;
+        static uint64_t         counter;
+        DynamicSpinLock dynamicLock(configuration);
+        lock    = &dynamicLock;
+        counter = 0;
+        std::vector<std::thread> threads;
+        for (unsigned t=0; t<4; t++) {
+            threads.emplace_back([] {
+                for (unsigned i=0; i<20'000; i++) {
+                    if (i % 8 == 0) {
+                        while (!lock->try_lock()) std::this_thread::yield();
+                    } else {
+                        lock->lock();
+                    }
+                    counter++;
+                    lock->unlock();
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        if (counter != 4*20'000) {
+            std::cout << "FAILED: '" << configuration << "' counter=" << counter << " (" << 4*20'000 << " expected). Exiting..\n\n";
+            exit(1);
+        }
+    }
+
+    for (const char* configuration : {"", "Foo", "Futex:Bar", "Futex:Yield:", "Futex:Yield:12x", "Futex:Yield:-5", "Futex:Yield:+5",
+                                      "Futex:Yield:1", "Futex:Yield:18446744073709551615", "Futex:Yield:18446744073709551614",
+                                      "Futex:Yield:99999999999999999999", "Futex:Yield:1000:2"}) {
+        try {
+            DynamicSpinLock lock(configuration);
+            std::cout << "FAILED: '" << configuration << "' was accepted as '" << lock.configuration() << "'. Exiting..\n\n";
+            exit(1);
+        } catch (const std::invalid_argument&) {}
+    }
+    for (uint64_t sentinel : {SpinLockAdaptiveHardLockFallback, SpinLockPreemptionAwareHardLockFallback}) {
+        try {
+            DynamicSpinLock lock(ELockSpecializations::Futex, ESpinMethod::Yield, sentinel);
+            std::cout << "FAILED: the sentinel " << sentinel << " was taken as a cycle count. Exiting..\n\n";
+            exit(1);
+        } catch (const std::invalid_argument&) {}
+    }
+    std::cout << "OK\n";
+}
+
+/** 'ESpinMethod::ExponentialBackoff' must start every wait at its floor: the backoff limit, grown while waiting for a lock
+  * held by another thread, must be reset as soon as the lock is acquired -- not only after the thread goes idle */
+template <typename _Lock>
+void checkExponentialBackoffReset(const char* lockName, _Lock& lock) {
+    static std::atomic<bool> held;
+    held = false;
+    std::thread holder([&lock] {
+        lock.lock();
+        held = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        lock.unlock();
+    });
+    while (!held) std::this_thread::yield();
+    lock.lock();
+    uint32_t limit = exponentialBackoffState.limit;
+    lock.unlock();
+    holder.join();
+    if (limit != 0) {
+        std::cout << "FAILED: '" << lockName << "' left the backoff limit at " << limit << " after acquiring. Exiting..\n\n";
+        exit(1);
+    }
+}
+
+void checkExponentialBackoffReset() {
+    std::cout << "\nChecking 'ESpinMethod::ExponentialBackoff' resets on acquisition... " << std::flush;
+    static SpinLock<ESpinMethod::ExponentialBackoff, ELockSpecializations::RMWLight>                                                 rmwLightLock;
+    static SpinLock<exponentialBackoffSpinMethod<8, 4096>(), ELockSpecializations::Ticket, /*_opMetrics*/true>                      ticketLock;
+    static SpinLock<ESpinMethod::ExponentialBackoff, ELockSpecializations::AtomicFlag, false, !(uint64_t)0, nullptr, 100'000'000> atomicFlagLock;
+    static DynamicSpinLock                                                                                                          dynamicLock("RMWLight:ExponentialBackoff:100000000");
+    checkExponentialBackoffReset("RMWLight", rmwLightLock);
+    checkExponentialBackoffReset("Ticket with metrics", ticketLock);
+    checkExponentialBackoffReset("AtomicFlag with hard lock fallback", atomicFlagLock);
+    checkExponentialBackoffReset("DynamicSpinLock", dynamicLock);
+    std::cout << "OK\n";
+}
+
+/** 'FlatCombiner::apply()' from several threads, mixing operations returning nothing, values & references -- and
+  * throwing, which must reach the calling thread and leave the data untouched */
+void checkFlatCombiner() {
+    constexpr unsigned nThreads    = 4;
+    constexpr unsigned nOperations = 50'000;
+    constexpr unsigned throwEvery  = 7;
+    struct Counters {
+        uint64_t voidIncrements  = 0;
+        uint64_t valueIncrements = 0;
+        uint64_t valuesSum       = 0;
+    };
+    static FlatCombiner<Counters, ESpinMethod::Yield> combiner;
+    static const Counters* dataAddress;
+    static std::atomic<uint64_t> returnedSum;
+    static std::atomic<unsigned> caughtCount;
+    static std::atomic<unsigned> wrongReferences;
+    dataAddress = &combiner.apply([](Counters& counters) -> Counters& { return counters; });
+    returnedSum = 0;
+    caughtCount = 0;
+    wrongReferences = 0;
+
+    std::cout << "\nChecking 'FlatCombiner' with " << nThreads << " threads... " << std::flush;
+    std::vector<std::thread> threads;
+    for (unsigned t=0; t<nThreads; t++) {
+        threads.emplace_back([] {
+            for (unsigned i=0; i<nOperations; i++) {
+                switch (i % 3) {
+                    case 0:
+                        combiner.apply([](Counters& counters) { counters.voidIncrements++; });
+                        break;
+                    case 1: {
+                        uint64_t value = combiner.apply([](Counters& counters) {
+                            uint64_t value = ++counters.valueIncrements;
+                            counters.valuesSum += value;
+                            return value;
+                        });
+                        returnedSum.fetch_add(value, std::memory_order_relaxed);
+                        break;
+                    }
+                    case 2: {
+                        const Counters& counters = combiner.apply([](Counters& counters) -> const Counters& { return counters; });
+                        if (&counters != dataAddress) {
+                            wrongReferences.fetch_add(1, std::memory_order_relaxed);
+                        }
+                        break;
+                    }
+                }
+                if (i % throwEvery == 0) {
+                    try {
+                        combiner.apply([](Counters& counters) -> uint64_t {
+                            throw std::runtime_error("operation failed");
+                            return ++counters.valueIncrements;
+                        });
+                    } catch (const std::runtime_error&) {
+                        caughtCount.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    Counters counters = combiner.apply([](Counters& counters) { return counters; });
+    uint64_t expectedVoids  = nThreads * ((nOperations+2) / 3);
+    uint64_t expectedValues = nThreads * ((nOperations+1) / 3);
+    uint64_t expectedCaught = nThreads * ((nOperations+throwEvery-1) / throwEvery);
+    if ( (counters.voidIncrements != expectedVoids) || (counters.valueIncrements != expectedValues) ||
+         (counters.valuesSum != returnedSum) || (counters.valuesSum != expectedValues*(expectedValues+1)/2) ||
+         (caughtCount != expectedCaught) || (wrongReferences != 0) ) {
+        std::cout << "FAILED: voidIncrements=" << counters.voidIncrements << " (" << expectedVoids << " expected), valueIncrements="
+                  << counters.valueIncrements << " (" << expectedValues << " expected), valuesSum=" << counters.valuesSum
+                  << " (" << returnedSum << " returned), caught exceptions=" << caughtCount << " (" << expectedCaught << " expected), "
+                     "wrong references=" << wrongReferences << ". Exiting..\n\n";
+        exit(1);
+    }
+    std::cout << "OK\n";
+}
+
+/** 'ESpinMethod::WaitOnAddress' on a lock strategy: contending threads increment a plain counter, which must end up exact */
+template <typename _Lock>
+void checkWaitOnAddressLock(const char* lockName) {
+    constexpr unsigned nThreads = 2;
+    constexpr unsigned nLocks   = 20'000;
+    static _Lock     lock;
+    static unsigned  counter;
+    counter = 0;
+    std::vector<std::thread> threads;
+    for (unsigned t=0; t<nThreads; t++) {
+        threads.emplace_back([] {
+            for (unsigned i=0; i<nLocks; i++) {
+                std::lock_guard<_Lock> guard(lock);
+                counter++;
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    if (counter != nThreads*nLocks) {
+        std::cout << "FAILED: '" << lockName << "' counter=" << counter << " (" << nThreads*nLocks << " expected). Exiting..\n\n";
+        exit(1);
+    }
+}
+
+/** 'ESpinMethod::WaitOnAddress' on the lock strategies watching a lock word -- on both their own spins and on 'SpinLock's
+  * controlled spin (enabled by metrics & hard lock fallbacks) -- and on 'SeqLock' & 'SharedSpinLock' */
+void checkWaitOnAddress() {
+    std::cout << "\nChecking 'ESpinMethod::WaitOnAddress' (" << (MTL_CPU_INSTR_WAITPKG ? "WAITPKG build" : "no WAITPKG in this build") << ")... " << std::flush;
+    checkWaitOnAddressLock<SpinLock<ESpinMethod::WaitOnAddress, ELockSpecializations::RMWLight>>("RMWLight");
+    checkWaitOnAddressLock<SpinLock<ESpinMethod::WaitOnAddress, ELockSpecializations::RMWLight, /*_opMetrics*/true>>("RMWLight with metrics");
+    checkWaitOnAddressLock<SpinLock<ESpinMethod::WaitOnAddress, ELockSpecializations::Ouroboros, /*_opMetrics*/true>>("Ouroboros with metrics");
+    checkWaitOnAddressLock<SpinLock<ESpinMethod::WaitOnAddress, ELockSpecializations::Ticket>>("Ticket");
+    checkWaitOnAddressLock<SpinLock<ESpinMethod::WaitOnAddress, ELockSpecializations::Futex, false, !(uint64_t)0, nullptr, 100'000>>("Futex with hard lock fallback");
+    checkWaitOnAddressLock<SpinLock<ESpinMethod::WaitOnAddress, ELockSpecializations::AtomicFlag, /*_opMetrics*/true>>("AtomicFlag with metrics");
+    checkWaitOnAddressLock<SharedSpinLock<ESpinMethod::WaitOnAddress, ELockSpecializations::RMWLight>>("SharedSpinLock");
+
+    struct Pair { uint64_t first; uint64_t second; };
+    static SeqLock<Pair, ESpinMethod::WaitOnAddress> seqLock;
+    static std::atomic<bool> writing;
+    writing = true;
+    std::thread writer([] {
+        for (uint64_t i=1; i<=20'000; i++) {
+            seqLock.write({i, i});
+        }
+        writing = false;
+    });
+    unsigned torn = 0;
+    while (writing) {
+        Pair pair = seqLock.read();
+        torn += pair.first != pair.second;
+    }
+    writer.join();
+    if (torn != 0) {
+        std::cout << "FAILED: 'SeqLock' gave " << torn << " torn reads. Exiting..\n\n";
+        exit(1);
+    }
+    std::cout << "OK\n";
+}
+
+/** stresses 'SeqLock': writers replace a block of equal values that readers must never see mixed up -- checking, as well,
+  * that the per thread reader metrics add up */
+template <typename _SeqLock, typename _Block>
+void checkSeqLock(const char* variant) {
+    constexpr unsigned nWriters = 2;
+    constexpr unsigned nReaders = 4;
+    constexpr unsigned nWrites  = 50'000;
+    static _SeqLock           seqLock;
+    std::atomic<bool>         stopReaders = ATOMIC_VAR_INIT(false);
+    std::atomic<unsigned>     torn        = ATOMIC_VAR_INIT(0);
+    std::atomic<uint64_t>     reads       = ATOMIC_VAR_INIT(0);
+    std::cout << "\nChecking 'SeqLock' (" << variant << ") for torn reads... " << std::flush;
+    std::vector<std::thread> threads;
+    for (unsigned r=0; r<nReaders; r++) {
+        threads.emplace_back([&] {
+            uint64_t localReads = 0;
+            while (!stopReaders.load(std::memory_order_relaxed)) {
+                _Block block = seqLock.read();
+                localReads++;
+                for (uint64_t value : block.values) {
+                    if (value != block.values[0]) {
+                        torn.fetch_add(1, std::memory_order_relaxed);
+                        break;
+                    }
+                }
+                std::this_thread::yield();
+            }
+            reads.fetch_add(localReads, std::memory_order_relaxed);
+        });
+    }
+    std::vector<std::thread> writers;
+    for (unsigned w=0; w<nWriters; w++) {
+        writers.emplace_back([&, w] {
+            for (uint64_t i=1; i<=nWrites; i++) {
+                seqLock.update([&](_Block& block) {
+                    for (uint64_t& value : block.values) {
+                        value = (i*nWriters) + w;
+                    }
+                });
+                if (i % 64 == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (std::thread& writer : writers) {
+        writer.join();
+    }
+    stopReaders = true;
+    for (std::thread& reader : threads) {
+        reader.join();
+    }
+    if (torn != 0) {
+        std::cout << "FAILED: 'SeqLock' gave " << torn << " torn reads. Exiting..\n\n";
+        exit(1);
+    }
+    auto metrics = seqLock.metricsSnapshot();
+    if (metrics.writesCount != nWriters*nWrites || metrics.readsCount != reads) {
+        std::cout << "FAILED: 'SeqLock' metrics say writesCount=" << metrics.writesCount << ", readsCount=" << metrics.readsCount
+                  << " (" << nWriters*nWrites << " & " << reads << " expected). Exiting..\n\n";
+        exit(1);
+    }
+    std::cout << "OK (" << reads << " reads, " << metrics.readRetriesCount << " retries)\n";
+}
+
+void checkSeqLock() {
+    struct Block { uint64_t values[16]; };
+    checkSeqLock<SeqLock<Block, ESpinMethod::Yield,         /*_opMetrics*/true>, Block>("yielding");
+    checkSeqLock<SeqLock<Block, ESpinMethod::WaitOnAddress, /*_opMetrics*/true>, Block>("waiting on the sequence");
+}
+
+/** stresses 'SharedSpinLock': writers update a pair of values that readers must never see out of sync */
+template <typename _SharedLock>
+void checkSharedSpinLock(const char* variant) {
+    constexpr unsigned nWriters = 2;
+    constexpr unsigned nReaders = 4;
+    constexpr unsigned nWrites  = 100'000;
+    static _SharedLock sharedLock;
+    static unsigned      first, second;
+    std::atomic<bool>     stopReaders = ATOMIC_VAR_INIT(false);
+    std::atomic<unsigned> nReads      = ATOMIC_VAR_INIT(0);
+    std::atomic<unsigned> nTornReads  = ATOMIC_VAR_INIT(0);
+    first = second = 0;
+
+    std::cout << "\nChecking 'SharedSpinLock' (" << variant << ") with " << nWriters << " writers & " << nReaders << " readers... " << std::flush;
+    std::vector<std::thread> readers;
+    for (unsigned r=0; r<nReaders; r++) {
+        readers.emplace_back([&, r] {
+            while (!stopReaders.load(std::memory_order_relaxed)) {
+                if (r % 2 == 0) {
+                    sharedLock.lock_shared();
+                } else if (!sharedLock.try_lock_shared()) {
+                    continue;
+                }
+                if (first != second) {
+                    nTornReads.fetch_add(1, std::memory_order_relaxed);
+                }
+                sharedLock.unlock_shared();
+                nReads.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+    std::vector<std::thread> writers;
+    for (unsigned w=0; w<nWriters; w++) {
+        writers.emplace_back([&] {
+            for (unsigned i=0; i<nWrites; i++) {
+                sharedLock.lock();
+                first++;
+                second++;
+                sharedLock.unlock();
+            }
+        });
+    }
+    for (std::thread& writer : writers) {
+        writer.join();
+    }
+    stopReaders.store(true, std::memory_order_relaxed);
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+
+    if ( (first != nWriters*nWrites) || (second != first) || (nTornReads != 0) ) {
+        std::cout << "FAILED: " << first << " & " << second << " writes (out of " << nWriters*nWrites << " expected), with "
+                  << nTornReads << " torn reads out of " << nReads << ". Exiting..\n\n";
+        exit(1);
+    }
+    std::cout << "OK (" << nReads << " reads)\n";
+}
+
+/** 'SharedSpinLock' spinning only and sleeping -- both writers waiting for readers and readers waiting for writers -- after a
+  * short hard lock fallback threshold */
+void checkSharedSpinLock() {
+    checkSharedSpinLock<SharedSpinLock<ESpinMethod::Yield, ELockSpecializations::RMWLight>>("spinning");
+    checkSharedSpinLock<SharedSpinLock<ESpinMethod::Yield, ELockSpecializations::Futex, false, !(uint64_t)0, nullptr, 10'000>>("sleeping after 10k cycles");
+}
+
 
 // spike methods
 ////////////////
@@ -594,12 +1386,30 @@ int main(void) {
     unsigned long long m_finish = getMonotonicRealTimeNS();
     uint64_t cc_finish = getProcessorCycleCount();
     uint64_t cc_split = getProcessorCycleCount();
+    unsigned startCore, endCore;
+    uint64_t fenced_start  = getProcessorCycleCountStart(startCore);
+    uint64_t fenced_finish = getProcessorCycleCountEnd(endCore);
 
     std::cout << "m_start   : " << m_start   << "\n"
                  "m_finish  : " << m_finish  << "\n"
                  "cc_start  : " << cc_start  << "\n"
                  "cc_finish : " << cc_finish << "\n"
-                 "min measurement: " << (cc_split-cc_finish) << "\n";
+                 "min measurement: " << (cc_split-cc_finish) << "\n"
+                 "min fenced measurement: " << (fenced_finish-fenced_start) << (startCore == endCore ? "" : " (migrated)") << "\n";
+    checkLatencyRecorder();
+
+    checkSpinLockHistogramsAndShardedMetrics();
+    checkSharedSpinLock();
+    checkSeqLock();
+    checkRobustFutexSpinLockOwnerDied();
+    checkFlatCombiner();
+    checkElidedLocks();
+    checkCohortLocks();
+    checkTimedLocks();
+    checkLockOrderValidator();
+    checkDynamicSpinLock();
+    checkExponentialBackoffReset();
+    checkWaitOnAddress();
     
 
     /*// spin lock tests
@@ -728,6 +1538,32 @@ int main(void) {
                         consumingRelaxFutexFallbackSpinLock.issueDebugMessage("final statistics");
 
 
+    //  relax 'futex' spin with an adaptive 'hard_lock' (spinless) fallback -- the spin budget is learnt at runtime
+    static SpinLock<ESpinMethod::CPURelax, ELockSpecializations::Futex, true, 5'000'000'000, producingLockName, SpinLockAdaptiveHardLockFallback> producingRelaxFutexAdaptiveFallbackSpinLock;
+    static SpinLock<ESpinMethod::CPURelax, ELockSpecializations::Futex, true, 5'000'000'000, consumingLockName, SpinLockAdaptiveHardLockFallback> consumingRelaxFutexAdaptiveFallbackSpinLock;
+    void (&relaxFutexAdaptiveHardLockFallbackProducer) (unsigned) = lockProducer  <producingRelaxFutexAdaptiveFallbackSpinLock, consumingRelaxFutexAdaptiveFallbackSpinLock>;
+    void (&relaxFutexAdaptiveHardLockFallbackConsumer) ()         = lockConsumer  <producingRelaxFutexAdaptiveFallbackSpinLock, consumingRelaxFutexAdaptiveFallbackSpinLock>;
+    void (&relaxFutexAdaptiveHardLockFallbackStop)     ()         = lockStop      <producingRelaxFutexAdaptiveFallbackSpinLock, consumingRelaxFutexAdaptiveFallbackSpinLock>;
+    void (&relaxFutexAdaptiveHardLockFallbackReset)    ()         = lockReset     <producingRelaxFutexAdaptiveFallbackSpinLock, consumingRelaxFutexAdaptiveFallbackSpinLock>;
+    void (&relaxFutexAdaptiveHardLockFallbackDebug)    ()         = debugDeadLock <producingRelaxFutexAdaptiveFallbackSpinLock, consumingRelaxFutexAdaptiveFallbackSpinLock>;
+    PERFORM_MEASUREMENT(0, relaxFutexAdaptiveHardLockFallbackProducer, relaxFutexAdaptiveHardLockFallbackConsumer,  relaxFutexAdaptiveHardLockFallbackStop, relaxFutexAdaptiveHardLockFallbackReset, relaxFutexAdaptiveHardLockFallbackDebug);
+                        producingRelaxFutexAdaptiveFallbackSpinLock.issueDebugMessage("final statistics");
+                        consumingRelaxFutexAdaptiveFallbackSpinLock.issueDebugMessage("final statistics");
+
+
+    //  relax 'futex' spin with a preemption aware 'hard_lock' (spinless) fallback -- also parks as soon as the lock holder is found not running
+    static SpinLock<ESpinMethod::CPURelax, ELockSpecializations::Futex, true, 5'000'000'000, producingLockName, SpinLockPreemptionAwareHardLockFallback> producingRelaxFutexPreemptionAwareFallbackSpinLock;
+    static SpinLock<ESpinMethod::CPURelax, ELockSpecializations::Futex, true, 5'000'000'000, consumingLockName, SpinLockPreemptionAwareHardLockFallback> consumingRelaxFutexPreemptionAwareFallbackSpinLock;
+    void (&relaxFutexPreemptionAwareHardLockFallbackProducer) (unsigned) = lockProducer  <producingRelaxFutexPreemptionAwareFallbackSpinLock, consumingRelaxFutexPreemptionAwareFallbackSpinLock>;
+    void (&relaxFutexPreemptionAwareHardLockFallbackConsumer) ()         = lockConsumer  <producingRelaxFutexPreemptionAwareFallbackSpinLock, consumingRelaxFutexPreemptionAwareFallbackSpinLock>;
+    void (&relaxFutexPreemptionAwareHardLockFallbackStop)     ()         = lockStop      <producingRelaxFutexPreemptionAwareFallbackSpinLock, consumingRelaxFutexPreemptionAwareFallbackSpinLock>;
+    void (&relaxFutexPreemptionAwareHardLockFallbackReset)    ()         = lockReset     <producingRelaxFutexPreemptionAwareFallbackSpinLock, consumingRelaxFutexPreemptionAwareFallbackSpinLock>;
+    void (&relaxFutexPreemptionAwareHardLockFallbackDebug)    ()         = debugDeadLock <producingRelaxFutexPreemptionAwareFallbackSpinLock, consumingRelaxFutexPreemptionAwareFallbackSpinLock>;
+    PERFORM_MEASUREMENT(0, relaxFutexPreemptionAwareHardLockFallbackProducer, relaxFutexPreemptionAwareHardLockFallbackConsumer,  relaxFutexPreemptionAwareHardLockFallbackStop, relaxFutexPreemptionAwareHardLockFallbackReset, relaxFutexPreemptionAwareHardLockFallbackDebug);
+                        producingRelaxFutexPreemptionAwareFallbackSpinLock.issueDebugMessage("final statistics");
+                        consumingRelaxFutexPreemptionAwareFallbackSpinLock.issueDebugMessage("final statistics");
+
+
     //  relax 'mutex' spin with 'hard_lock' (spinless) fallback
     static SpinLock<ESpinMethod::CPURelax, ELockSpecializations::Mutex, true, 5'000'000'000, producingLockName, 6'500'000'000> producingRelaxMutexFallbackSpinLock;
     static SpinLock<ESpinMethod::CPURelax, ELockSpecializations::Mutex, true, 5'000'000'000, consumingLockName, 6'500'000'000> consumingRelaxMutexFallbackSpinLock;
@@ -751,6 +1587,48 @@ int main(void) {
 	void (&relaxRMWLightSpinDebug)    ()         = debugDeadLock <producingRelaxRMWLightSpin, consumingRelaxRMWLightSpin>;
 	PERFORM_MEASUREMENT(1,          relaxRMWLightSpinProducer,         relaxRMWLightSpinConsumer,          relaxRMWLightSpinStop,           relaxRMWLightSpinReset,           relaxRMWLightSpinDebug);
 
+	// exponential backoff, light in Read-Modify-Write spin
+	// ** here is demonstrated how much the jittered backoff reduces the failed RMWs as the number of producers & consumers grows
+	static SpinLock<exponentialBackoffSpinMethod<4, 1024>(), ELockSpecializations::RMWLight> producingBackoffRMWLightSpin;
+	static SpinLock<exponentialBackoffSpinMethod<4, 1024>(), ELockSpecializations::RMWLight> consumingBackoffRMWLightSpin;
+	void (&backoffRMWLightSpinProducer) (unsigned) = lockProducer  <producingBackoffRMWLightSpin, consumingBackoffRMWLightSpin>;
+	void (&backoffRMWLightSpinConsumer) ()         = lockConsumer  <producingBackoffRMWLightSpin, consumingBackoffRMWLightSpin>;
+	void (&backoffRMWLightSpinStop)     ()         = lockStop      <producingBackoffRMWLightSpin, consumingBackoffRMWLightSpin>;
+	void (&backoffRMWLightSpinReset)    ()         = lockReset     <producingBackoffRMWLightSpin, consumingBackoffRMWLightSpin>;
+	void (&backoffRMWLightSpinDebug)    ()         = debugDeadLock <producingBackoffRMWLightSpin, consumingBackoffRMWLightSpin>;
+	PERFORM_MEASUREMENT(1,        backoffRMWLightSpinProducer,       backoffRMWLightSpinConsumer,        backoffRMWLightSpinStop,         backoffRMWLightSpinReset,         backoffRMWLightSpinDebug);
+
+	// relax ticket lock
+	static SpinLock<ESpinMethod::CPURelax, ELockSpecializations::Ticket> producingRelaxTicketSpin;
+	static SpinLock<ESpinMethod::CPURelax, ELockSpecializations::Ticket> consumingRelaxTicketSpin;
+	void (&relaxTicketSpinProducer) (unsigned) = lockProducer  <producingRelaxTicketSpin, consumingRelaxTicketSpin>;
+	void (&relaxTicketSpinConsumer) ()         = lockConsumer  <producingRelaxTicketSpin, consumingRelaxTicketSpin>;
+	void (&relaxTicketSpinStop)     ()         = lockStop      <producingRelaxTicketSpin, consumingRelaxTicketSpin>;
+	void (&relaxTicketSpinReset)    ()         = lockReset     <producingRelaxTicketSpin, consumingRelaxTicketSpin>;
+	void (&relaxTicketSpinDebug)    ()         = debugDeadLock <producingRelaxTicketSpin, consumingRelaxTicketSpin>;
+	PERFORM_MEASUREMENT(1,            relaxTicketSpinProducer,           relaxTicketSpinConsumer,            relaxTicketSpinStop,             relaxTicketSpinReset,             relaxTicketSpinDebug);
+
+	// relax MCS queue lock
+	// ** each waiter spins on its own cache line, so the handoff latency should stay flat as the number of producers & consumers grows
+	static SpinLock<ESpinMethod::CPURelax, ELockSpecializations::MCS> producingRelaxMCSSpin;
+	static SpinLock<ESpinMethod::CPURelax, ELockSpecializations::MCS> consumingRelaxMCSSpin;
+	void (&relaxMCSSpinProducer) (unsigned) = lockProducer  <producingRelaxMCSSpin, consumingRelaxMCSSpin>;
+	void (&relaxMCSSpinConsumer) ()         = lockConsumer  <producingRelaxMCSSpin, consumingRelaxMCSSpin>;
+	void (&relaxMCSSpinStop)     ()         = lockStop      <producingRelaxMCSSpin, consumingRelaxMCSSpin>;
+	void (&relaxMCSSpinReset)    ()         = lockReset     <producingRelaxMCSSpin, consumingRelaxMCSSpin>;
+	void (&relaxMCSSpinDebug)    ()         = debugDeadLock <producingRelaxMCSSpin, consumingRelaxMCSSpin>;
+	PERFORM_MEASUREMENT(1,               relaxMCSSpinProducer,              relaxMCSSpinConsumer,               relaxMCSSpinStop,                relaxMCSSpinReset,                relaxMCSSpinDebug);
+
+	// relax CLH queue lock
+	static SpinLock<ESpinMethod::CPURelax, ELockSpecializations::CLH> producingRelaxCLHSpin;
+	static SpinLock<ESpinMethod::CPURelax, ELockSpecializations::CLH> consumingRelaxCLHSpin;
+	void (&relaxCLHSpinProducer) (unsigned) = lockProducer  <producingRelaxCLHSpin, consumingRelaxCLHSpin>;
+	void (&relaxCLHSpinConsumer) ()         = lockConsumer  <producingRelaxCLHSpin, consumingRelaxCLHSpin>;
+	void (&relaxCLHSpinStop)     ()         = lockStop      <producingRelaxCLHSpin, consumingRelaxCLHSpin>;
+	void (&relaxCLHSpinReset)    ()         = lockReset     <producingRelaxCLHSpin, consumingRelaxCLHSpin>;
+	void (&relaxCLHSpinDebug)    ()         = debugDeadLock <producingRelaxCLHSpin, consumingRelaxCLHSpin>;
+	PERFORM_MEASUREMENT(1,               relaxCLHSpinProducer,              relaxCLHSpinConsumer,               relaxCLHSpinStop,                relaxCLHSpinReset,                relaxCLHSpinDebug);
+
 
 
     static unsigned debugVal;